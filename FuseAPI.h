@@ -24,6 +24,7 @@ using std::unexpected;
 
 #define FUSE_USE_VERSION 26
 #include "fuse.h"
+#include "fuse_lowlevel.h"
 
 //
 // Fuse operations as defined in fuse.h
@@ -98,6 +99,28 @@ using std::unexpected;
 #define FUSE_FSETATTR_X  int (*fsetattr_x) (const char *, struct setattr_x *, struct fuse_file_info *)
 #endif
 
+//
+// Fuse low-level operations as defined in fuse_lowlevel.h
+//
+
+#define FUSE_LL_LOOKUP   void (ll_lookup) (fuse_req_t, fuse_ino_t, const char *)
+#define FUSE_LL_FORGET   void (ll_forget) (fuse_req_t, fuse_ino_t, unsigned long)
+#define FUSE_LL_GETATTR  void (ll_getattr) (fuse_req_t, fuse_ino_t, struct fuse_file_info *)
+#define FUSE_LL_SETATTR  void (ll_setattr) (fuse_req_t, fuse_ino_t, struct stat *, int, struct fuse_file_info *)
+#define FUSE_LL_MKDIR    void (ll_mkdir) (fuse_req_t, fuse_ino_t, const char *, mode_t)
+#define FUSE_LL_UNLINK   void (ll_unlink) (fuse_req_t, fuse_ino_t, const char *)
+#define FUSE_LL_RMDIR    void (ll_rmdir) (fuse_req_t, fuse_ino_t, const char *)
+#define FUSE_LL_RENAME   void (ll_rename) (fuse_req_t, fuse_ino_t, const char *, fuse_ino_t, const char *)
+#define FUSE_LL_OPEN     void (ll_open) (fuse_req_t, fuse_ino_t, struct fuse_file_info *)
+#define FUSE_LL_READ     void (ll_read) (fuse_req_t, fuse_ino_t, size_t, off_t, struct fuse_file_info *)
+#define FUSE_LL_WRITE    void (ll_write) (fuse_req_t, fuse_ino_t, const char *, size_t, off_t, struct fuse_file_info *)
+#define FUSE_LL_FLUSH    void (ll_flush) (fuse_req_t, fuse_ino_t, struct fuse_file_info *)
+#define FUSE_LL_RELEASE  void (ll_release) (fuse_req_t, fuse_ino_t, struct fuse_file_info *)
+#define FUSE_LL_FSYNC    void (ll_fsync) (fuse_req_t, fuse_ino_t, int, struct fuse_file_info *)
+#define FUSE_LL_READDIR  void (ll_readdir) (fuse_req_t, fuse_ino_t, size_t, off_t, struct fuse_file_info *)
+#define FUSE_LL_STATFS   void (ll_statfs) (fuse_req_t, fuse_ino_t)
+#define FUSE_LL_CREATE   void (ll_create) (fuse_req_t, fuse_ino_t, const char *, mode_t, struct fuse_file_info *)
+
 /*
  #define FUSE_GETATTR(P)     int (P##getattr) (const char *, struct stat *)
  #define FUSE_READLINK(P)    int (P##readlink) (const char *, char *, size_t)
@@ -262,8 +262,10 @@ FuseDevice::writeByte(isize offset, u8 value)
      
         image->writeByte(offset, value);
         dirty = true;
+
+        // The edit bypassed the file systems
+        for (auto &volume : volumes) { volume->revalidate(true); }
     }
-    
 }
 
 void
@@ -273,5 +275,8 @@ FuseDevice::writeByte(isize offset, u8 value, isize volume)
         
         volumes[volume]->getVolume().writeByte(offset, value);
         dirty = true;
+
+        // The edit bypassed the file system
+        volumes[volume]->revalidate(true);
     }
 }
@@ -7,4 +7,27 @@
 // See https://mozilla.org/MPL/2.0 for license information
 // -----------------------------------------------------------------------------
 
+#pragma once
+
 typedef void AdapterCallback(const void *, int);
+
+// Kernel caching policy of a mounted volume
+struct FuseCacheOptions {
+
+    double attrTimeout = 1.0;       // Validity of cached attributes (seconds)
+    double entryTimeout = 1.0;      // Validity of cached directory entries (seconds)
+    double negativeTimeout = 0.0;   // Validity of cached lookup misses (seconds)
+    bool kernelCache = false;       // Keep cached file pages when a file is opened
+    bool autoCache = false;         // Keep cached file pages unless the file has changed (opt-in,
+                                    // misses edits that bypass FUSE on high-level mounts)
+};
+
+// Transfer tuning of a mounted volume (0 = FUSE default)
+struct FuseTransferOptions {
+
+    bool bigWrites = false;         // Allow write requests larger than a page
+    int maxWrite = 0;               // Maximum size of a write request (bytes)
+    int maxRead = 0;                // Maximum size of a read request (bytes)
+    int maxReadahead = 0;           // Maximum kernel readahead (bytes)
+    bool writebackCache = false;    // Let the kernel buffer writes (if supported)
+};
@@ -10,8 +10,12 @@
 #include "FuseMountPoint.h"
 #include "FileSystem.h"
 #include <fuse.h>
+#include <fuse_lowlevel.h>
+#include <atomic>
+#include <format>
 #include <iostream>
 #include <sys/mount.h>
+#include <vector>
 
 fuse_operations
 FuseMountPoint::callbacks = {
@@ -27,7 +31,9 @@ FuseMountPoint::callbacks = {
     .read       = hooks::read,
     .write      = hooks::write,
     .statfs     = hooks::statfs,
+    .flush      = hooks::flush,
     .release    = hooks::release,
+    .fsync      = hooks::fsync,
     .readdir    = hooks::readdir,
     .init       = hooks::init,
     .destroy    = hooks::destroy,
@@ -36,6 +42,30 @@ FuseMountPoint::callbacks = {
     .utimens    = hooks::utimens
 };
 
+fuse_lowlevel_ops
+FuseMountPoint::llcallbacks = {
+
+    .init       = hooks::ll_init,
+    .destroy    = hooks::ll_destroy,
+    .lookup     = hooks::ll_lookup,
+    .forget     = hooks::ll_forget,
+    .getattr    = hooks::ll_getattr,
+    .setattr    = hooks::ll_setattr,
+    .mkdir      = hooks::ll_mkdir,
+    .unlink     = hooks::ll_unlink,
+    .rmdir      = hooks::ll_rmdir,
+    .rename     = hooks::ll_rename,
+    .open       = hooks::ll_open,
+    .read       = hooks::ll_read,
+    .write      = hooks::ll_write,
+    .flush      = hooks::ll_flush,
+    .release    = hooks::ll_release,
+    .fsync      = hooks::ll_fsync,
+    .readdir    = hooks::ll_readdir,
+    .statfs     = hooks::ll_statfs,
+    .create     = hooks::ll_create
+};
+
 void
 FuseMountPoint::setListener(const void *listener, AdapterCallback *callback)
 {
@@ -62,6 +92,26 @@ FuseMountPoint::mount(const fs::path &mp)
         fuse_opt_add_arg(&args, "-olocal"); // Make the volume appear in Finder
         fuse_opt_add_arg(&args, volopt.c_str());
 
+        // The high-level library caches on our behalf. In low-level mode,
+        // the timeouts are handed over with each reply instead.
+        auto cacheopt = std::format("-oattr_timeout={},entry_timeout={},negative_timeout={}",
+                                    cacheOptions.attrTimeout,
+                                    cacheOptions.entryTimeout,
+                                    cacheOptions.negativeTimeout);
+        if (!lowlevel) {
+
+            fuse_opt_add_arg(&args, cacheopt.c_str());
+            if (cacheOptions.kernelCache) fuse_opt_add_arg(&args, "-okernel_cache");
+            if (cacheOptions.autoCache) fuse_opt_add_arg(&args, "-oauto_cache");
+        }
+
+        // Request sizes are negotiated the same way by both APIs
+        const auto &tuning = transferOptions;
+        if (tuning.bigWrites) fuse_opt_add_arg(&args, "-obig_writes");
+        if (tuning.maxWrite) fuse_opt_add_arg(&args, std::format("-omax_write={}", tuning.maxWrite).c_str());
+        if (tuning.maxRead) fuse_opt_add_arg(&args, std::format("-omax_read={}", tuning.maxRead).c_str());
+        if (tuning.maxReadahead) fuse_opt_add_arg(&args, std::format("-omax_readahead={}", tuning.maxReadahead).c_str());
+
         try {
 
             printf("mp.c_str() = %s\n", mountPoint.c_str());
@@ -72,27 +122,19 @@ FuseMountPoint::mount(const fs::path &mp)
                 printf("Channel is null\n");
                 return;
             }
-            gateway = fuse_new(channel, &args, &callbacks, sizeof(callbacks), this);
-            if (!gateway) {
+            if (!connect(channel, &args)) {
 
-                printf("Gateway is null\n");
+                printf("Session is null\n");
                 fuse_unmount(mountPoint.c_str(), channel);
                 return;
             }
 
             // Blocking loop (runs until unmounted or fuse_exit called)
-            printf("Launching fuse loop...\n");
-            fuse_loop(gateway);
-
-            // Remove the mount point
-            printf("Unmouting %s\n", mountPoint.c_str());
-            fuse_unmount(mountPoint.c_str(), channel);
+            printf("Launching fuse loop (%d workers)...\n", workers);
+            if (workers > 1) loopMT(); else fuse_session_loop(session);
 
             // Cleanup
-            printf("Destroy...\n");
-            fuse_destroy(gateway);
-            gateway = nullptr;
-            printf("Destroyed.\n");
+            disconnect(channel);
             if (listener) { callback(listener, 42); }
 
         } catch (std::exception &e) {
@@ -129,10 +171,10 @@ FuseMountPoint::unmount()
 {
     printf("FuseAdapter::unmount()\n");
 
-    if (gateway) {
+    if (session) {
         
-        printf("Calling fuse_exit...\n");
-        fuse_exit(gateway);
+        printf("Calling fuse_session_exit...\n");
+        fuse_session_exit(session);
     }
 
     printf("Waiting for the thread to terminate...\n");
@@ -145,6 +187,128 @@ FuseMountPoint::unmount()
     printf("Done.\n");
 }
 
+bool
+FuseMountPoint::connect(struct fuse_chan *channel, struct fuse_args *args)
+{
+    if (lowlevel) {
+
+        // Requests are keyed by inode and dispatched to the ll_ members
+        session = fuse_lowlevel_new(args, &llcallbacks, sizeof(llcallbacks), this);
+        if (session) fuse_session_add_chan(session, channel);
+
+    } else {
+
+        // Requests are keyed by path and dispatched by the FUSE library
+        gateway = fuse_new(channel, args, &callbacks, sizeof(callbacks), this);
+        if (gateway) session = fuse_get_session(gateway);
+    }
+
+    return session != nullptr;
+}
+
+void
+FuseMountPoint::disconnect(struct fuse_chan *channel)
+{
+    printf("Unmouting %s\n", mountPoint.c_str());
+
+    if (gateway) {
+
+        // The high-level API owns the session
+        fuse_unmount(mountPoint.c_str(), channel);
+        fuse_destroy(gateway);
+
+    } else {
+
+        // The channel must be detached before the session is destroyed
+        fuse_session_remove_chan(channel);
+        fuse_session_destroy(session);
+        fuse_unmount(mountPoint.c_str(), channel);
+    }
+
+    gateway = nullptr;
+    session = nullptr;
+    printf("Destroyed.\n");
+}
+
+void
+FuseMountPoint::configure(struct fuse_conn_info *conn)
+{
+#ifdef FUSE_CAP_WRITEBACK_CACHE
+
+    // Let the kernel buffer writes and hand them over in large chunks
+    if (transferOptions.writebackCache && (conn->capable & FUSE_CAP_WRITEBACK_CACHE)) {
+        conn->want |= FUSE_CAP_WRITEBACK_CACHE;
+    }
+
+#else
+
+    if (transferOptions.writebackCache) {
+        mylog("Write-back caching is not supported by this version of FUSE\n");
+    }
+
+#endif
+}
+
+int
+FuseMountPoint::invalidateInode(fuse_ino_t ino)
+{
+    // The high-level API of FUSE 2 cannot address individual inodes
+    if (!session || gateway) return -ENOTCONN;
+
+    auto *channel = fuse_session_next_chan(session, nullptr);
+    return fuse_lowlevel_notify_inval_inode(channel, ino, 0, 0);
+}
+
+int
+FuseMountPoint::invalidateEntry(fuse_ino_t parent, const string &name)
+{
+    // The high-level API of FUSE 2 cannot address individual entries
+    if (!session || gateway) return -ENOTCONN;
+
+    auto *channel = fuse_session_next_chan(session, nullptr);
+    return fuse_lowlevel_notify_inval_entry(channel, parent, name.c_str(), name.size());
+}
+
+int
+FuseMountPoint::loopMT()
+{
+    // The FUSE 2 API offers no way to configure the threads of fuse_loop_mt.
+    // Hence, we run our own worker pool on top of the session API.
+    auto *channel = fuse_session_next_chan(session, nullptr);
+    auto bufsize  = fuse_chan_bufsize(channel);
+
+    std::atomic<int> error = 0;
+    std::vector<std::thread> pool;
+
+    for (int i = 0; i < workers; i++) {
+
+        pool.emplace_back([&]() {
+
+            std::vector<char> buffer(bufsize);
+
+            while (!fuse_session_exited(session)) {
+
+                // Wait for the next request (all workers share the channel)
+                auto *ch = channel;
+                auto res = fuse_chan_recv(&ch, buffer.data(), bufsize);
+
+                if (res == -EINTR) continue;
+                if (res <= 0) { if (res < 0) error = res; break; }
+
+                fuse_session_process(session, buffer.data(), res, ch);
+            }
+
+            // Make the other workers leave their loops, too
+            fuse_session_exit(session);
+        });
+    }
+
+    for (auto &thread : pool) thread.join();
+
+    fuse_session_reset(session);
+    return error < 0 ? -1 : 0;
+}
+
 int
 FuseMountPoint::hooks::getattr(const char *path, struct stat* st)
 {
@@ -222,6 +386,13 @@ FuseMountPoint::hooks::statfs(const char *path, struct statvfs *st)
     return self().statfs(path, st);
 }
 
+int
+FuseMountPoint::hooks::flush(const char *path, struct fuse_file_info *fi)
+{
+    mylog("[flush]    %s\n", path);
+    return self().flush(path, fi);
+}
+
 int
 FuseMountPoint::hooks::release(const char *path, struct fuse_file_info *fi)
 {
@@ -229,6 +400,13 @@ FuseMountPoint::hooks::release(const char *path, struct fuse_file_info *fi)
     return self().release(path, fi);
 }
 
+int
+FuseMountPoint::hooks::fsync(const char *path, int datasync, struct fuse_file_info *fi)
+{
+    mylog("[fsync]    %s, %d\n", path, datasync);
+    return self().fsync(path, datasync, fi);
+}
+
 int
 FuseMountPoint::hooks::readdir(const char* path, void* buf, fuse_fill_dir_t filler,
                off_t offset, struct fuse_file_info* fi)
@@ -241,6 +419,7 @@ void *
 FuseMountPoint::hooks::init(struct fuse_conn_info* conn)
 {
     mylog("[init]");
+    self().configure(conn);
 
     // We ignore the result of the delegate method
     (void)self().init(conn);
@@ -276,3 +455,137 @@ FuseMountPoint::hooks::utimens(const char *path, const struct timespec tv[2])
     mylog("[utimens]  %s\n", path);
     return self().utimens(path, tv);
 }
+
+void
+FuseMountPoint::hooks::ll_init(void *userdata, struct fuse_conn_info *conn)
+{
+    mylog("[ll_init]\n");
+    static_cast<FuseMountPoint *>(userdata)->configure(conn);
+    (void)static_cast<FuseMountPoint *>(userdata)->init(conn);
+}
+
+void
+FuseMountPoint::hooks::ll_destroy(void *userdata)
+{
+    mylog("[ll_destroy] %p\n", userdata);
+    static_cast<FuseMountPoint *>(userdata)->destroy(userdata);
+}
+
+void
+FuseMountPoint::hooks::ll_lookup(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    mylog("[lookup]   %lu, %s\n", parent, name);
+    self(req).ll_lookup(req, parent, name);
+}
+
+void
+FuseMountPoint::hooks::ll_forget(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup)
+{
+    mylog("[forget]   %lu, %lu\n", ino, nlookup);
+    self(req).ll_forget(req, ino, nlookup);
+}
+
+void
+FuseMountPoint::hooks::ll_getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+{
+    mylog("[getattr]  %lu\n", ino);
+    self(req).ll_getattr(req, ino, fi);
+}
+
+void
+FuseMountPoint::hooks::ll_setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int toSet, struct fuse_file_info *fi)
+{
+    mylog("[setattr]  %lu, %x\n", ino, toSet);
+    self(req).ll_setattr(req, ino, attr, toSet, fi);
+}
+
+void
+FuseMountPoint::hooks::ll_mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode)
+{
+    mylog("[mkdir]    %lu, %s, %x\n", parent, name, mode);
+    self(req).ll_mkdir(req, parent, name, mode);
+}
+
+void
+FuseMountPoint::hooks::ll_unlink(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    mylog("[unlink]   %lu, %s\n", parent, name);
+    self(req).ll_unlink(req, parent, name);
+}
+
+void
+FuseMountPoint::hooks::ll_rmdir(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    mylog("[rmdir]    %lu, %s\n", parent, name);
+    self(req).ll_rmdir(req, parent, name);
+}
+
+void
+FuseMountPoint::hooks::ll_rename(fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname)
+{
+    mylog("[rename]   %lu, %s, %lu, %s\n", parent, name, newparent, newname);
+    self(req).ll_rename(req, parent, name, newparent, newname);
+}
+
+void
+FuseMountPoint::hooks::ll_open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+{
+    mylog("[open]     %lu\n", ino);
+    self(req).ll_open(req, ino, fi);
+}
+
+void
+FuseMountPoint::hooks::ll_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *fi)
+{
+    mylog("[read]     %lu, %ld, %lld\n", ino, size, offset);
+    self(req).ll_read(req, ino, size, offset, fi);
+}
+
+void
+FuseMountPoint::hooks::ll_write(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+{
+    mylog("[write]    %lu, %ld, %lld\n", ino, size, offset);
+    self(req).ll_write(req, ino, buf, size, offset, fi);
+}
+
+void
+FuseMountPoint::hooks::ll_flush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+{
+    mylog("[flush]    %lu\n", ino);
+    self(req).ll_flush(req, ino, fi);
+}
+
+void
+FuseMountPoint::hooks::ll_release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+{
+    mylog("[release]  %lu\n", ino);
+    self(req).ll_release(req, ino, fi);
+}
+
+void
+FuseMountPoint::hooks::ll_fsync(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info *fi)
+{
+    mylog("[fsync]    %lu, %d\n", ino, datasync);
+    self(req).ll_fsync(req, ino, datasync, fi);
+}
+
+void
+FuseMountPoint::hooks::ll_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *fi)
+{
+    mylog("[readdir]  %lu, %lld\n", ino, offset);
+    self(req).ll_readdir(req, ino, size, offset, fi);
+}
+
+void
+FuseMountPoint::hooks::ll_statfs(fuse_req_t req, fuse_ino_t ino)
+{
+    mylog("[statfs]   %lu\n", ino);
+    self(req).ll_statfs(req, ino);
+}
+
+void
+FuseMountPoint::hooks::ll_create(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, struct fuse_file_info *fi)
+{
+    mylog("[create]   %lu, %s, %x\n", parent, name, mode);
+    self(req).ll_create(req, parent, name, mode, fi);
+}
@@ -12,6 +12,7 @@
 #include "FuseAPI.h"
 #include "FuseFileSystemTypes.h"
 #include "FuseDebug.h"
+#include <algorithm>
 #include <thread>
 
 class FuseMountPoint {
@@ -19,17 +20,35 @@ class FuseMountPoint {
     // Background thread
     std::thread fuseThread;
     
-    // Gateway to the FUSE backend
+    // Gateway to the FUSE backend (high-level API)
     struct fuse *gateway = nullptr;
 
+    // Session of the FUSE backend (used by both APIs)
+    struct fuse_session *session = nullptr;
+
     // Volume name
     string volname;
 
     // Mount point in the host file system ("/Volumes/...")
     fs::path mountPoint;
-    
+
+    // Number of threads serving FUSE requests (1 = single-threaded loop)
+    int workers = 1;
+
+    // Indicates whether the inode-based low-level API is used
+    bool lowlevel = false;
+
+    // Kernel caching policy
+    FuseCacheOptions cacheOptions;
+
+    // Request size and write-back tuning
+    FuseTransferOptions transferOptions;
+
 public:
 
+    // Maximum number of worker threads
+    static constexpr int maxWorkers = 16;
+
     // Set to true to enable debug messages
     bool debug = true;
         
@@ -58,13 +77,35 @@ private:
         static FUSE_READ;
         static FUSE_WRITE;
         static FUSE_STATFS;
+        static FUSE_FLUSH;
         static FUSE_RELEASE;
+        static FUSE_FSYNC;
         static FUSE_READDIR;
         static FUSE_INIT;
         static FUSE_DESTROY;
         static FUSE_ACCESS;
         static FUSE_CREATE;
         static FUSE_UTIMENS;
+
+        static void ll_init(void *, struct fuse_conn_info *);
+        static void ll_destroy(void *);
+        static FUSE_LL_LOOKUP;
+        static FUSE_LL_FORGET;
+        static FUSE_LL_GETATTR;
+        static FUSE_LL_SETATTR;
+        static FUSE_LL_MKDIR;
+        static FUSE_LL_UNLINK;
+        static FUSE_LL_RMDIR;
+        static FUSE_LL_RENAME;
+        static FUSE_LL_OPEN;
+        static FUSE_LL_READ;
+        static FUSE_LL_WRITE;
+        static FUSE_LL_FLUSH;
+        static FUSE_LL_RELEASE;
+        static FUSE_LL_FSYNC;
+        static FUSE_LL_READDIR;
+        static FUSE_LL_STATFS;
+        static FUSE_LL_CREATE;
     };
 
     // Class members called from the static hooks
@@ -80,7 +121,9 @@ private:
     virtual FUSE_READ     { return -ENOSYS; }
     virtual FUSE_WRITE    { return -ENOSYS; }
     virtual FUSE_STATFS   { return -ENOSYS; }
+    virtual FUSE_FLUSH    { return -ENOSYS; }
     virtual FUSE_RELEASE  { return -ENOSYS; }
+    virtual FUSE_FSYNC    { return -ENOSYS; }
     virtual FUSE_READDIR  { return -ENOSYS; }
     virtual FUSE_INIT     { return nullptr; }
     virtual FUSE_DESTROY  { }
@@ -88,16 +131,74 @@ private:
     virtual FUSE_CREATE   { return -ENOSYS; }
     virtual FUSE_UTIMENS  { return -ENOSYS; }
 
+    // Class members called from the static low-level hooks (keyed by inode)
+    virtual FUSE_LL_LOOKUP  = 0;
+    virtual FUSE_LL_FORGET  = 0;
+    virtual FUSE_LL_GETATTR = 0;
+    virtual FUSE_LL_SETATTR = 0;
+    virtual FUSE_LL_MKDIR   = 0;
+    virtual FUSE_LL_UNLINK  = 0;
+    virtual FUSE_LL_RMDIR   = 0;
+    virtual FUSE_LL_RENAME  = 0;
+    virtual FUSE_LL_OPEN    = 0;
+    virtual FUSE_LL_READ    = 0;
+    virtual FUSE_LL_WRITE   = 0;
+    virtual FUSE_LL_FLUSH   = 0;
+    virtual FUSE_LL_RELEASE = 0;
+    virtual FUSE_LL_FSYNC   = 0;
+    virtual FUSE_LL_READDIR = 0;
+    virtual FUSE_LL_STATFS  = 0;
+    virtual FUSE_LL_CREATE  = 0;
+
     static fuse_operations callbacks;
+    static fuse_lowlevel_ops llcallbacks;
 
     static FuseMountPoint &self() {
         return *(static_cast<FuseMountPoint *>(fuse_get_context()->private_data));
     }
 
+    static FuseMountPoint &self(fuse_req_t req) {
+        return *(static_cast<FuseMountPoint *>(fuse_req_userdata(req)));
+    }
+
+    // Serves FUSE requests with multiple threads until the session ends
+    int loopMT();
+
+    // Connects the mounted channel to a FUSE session (returns false on failure)
+    bool connect(struct fuse_chan *channel, struct fuse_args *args);
+
+    // Tears down the FUSE session and removes the mount point
+    void disconnect(struct fuse_chan *channel);
+
+    // Negotiates optional capabilities with the kernel
+    void configure(struct fuse_conn_info *conn);
+
 public:
 
     const fs::path &getMountPoint() const { return mountPoint; }
 
+    // Gets or sets the number of worker threads (applies to the next mount)
+    int getWorkers() const { return workers; }
+    void setWorkers(int count) { workers = std::clamp(count, 1, maxWorkers); }
+
+    // Selects the path-based or the inode-based API (applies to the next mount)
+    bool usesLowLevelAPI() const { return lowlevel; }
+    void useLowLevelAPI(bool yesno) { lowlevel = yesno; }
+
+    // Gets or sets the kernel caching policy (applies to the next mount)
+    const FuseCacheOptions &getCacheOptions() const { return cacheOptions; }
+    void setCacheOptions(const FuseCacheOptions &options) { cacheOptions = options; }
+
+    // Gets or sets the request size and write-back tuning (applies to the next mount)
+    const FuseTransferOptions &getTransferOptions() const { return transferOptions; }
+    void setTransferOptions(const FuseTransferOptions &options) { transferOptions = options; }
+
+    // Asks the kernel to drop cached data of an inode or a directory entry.
+    // Notifications require the low-level API and must not be sent while a
+    // lock is held that request handlers may wait for.
+    int invalidateInode(fuse_ino_t ino);
+    int invalidateEntry(fuse_ino_t parent, const string &name);
+
     // Mounts a file system at the provides mount point
     void mount(const fs::path &mountpoint);
 
@@ -57,29 +57,39 @@ FuseVolume::~FuseVolume()
     printf("Destroying FuseVolume\n");
 }
 
+void
+FuseVolume::toStat(const FSPosixAttr &attr, struct stat *st)
+{
+    auto create = attr.ctime;
+    auto modify = attr.mtime;
+
+    memset(st, 0, sizeof(*st));
+
+    st->st_mode = attr.prot;
+    st->st_nlink = 1;
+    st->st_size = attr.size;
+    st->st_birthtimespec.tv_sec  = create;
+    st->st_birthtimespec.tv_nsec = 0;
+    st->st_mtimespec.tv_sec      = modify ? modify : create;
+    st->st_mtimespec.tv_nsec     = 0;
+    st->st_ctimespec.tv_sec      = modify ? modify : create;
+    st->st_ctimespec.tv_nsec     = 0;
+    st->st_atimespec.tv_sec      = modify ? modify : create;
+    st->st_atimespec.tv_nsec     = 0;
+}
+
 int
 FuseVolume::getattr(const char *path, struct stat *st)
 {
     memset(st, 0, sizeof(*st));
 
-    return fsexec([&]{
+    return fsread([&]{
 
-        auto attr   = dos->attr(path);
-        auto create = attr.ctime;
-        auto modify = attr.mtime;
-
-        st->st_mode = attr.prot;
-        st->st_nlink = 1;
-        st->st_size = attr.size;
-        st->st_birthtimespec.tv_sec  = create;
-        st->st_birthtimespec.tv_nsec = 0;
-        st->st_mtimespec.tv_sec      = modify ? modify : create;
-        st->st_mtimespec.tv_nsec     = 0;
-        st->st_ctimespec.tv_sec      = modify ? modify : create;
-        st->st_ctimespec.tv_nsec     = 0;
-        st->st_atimespec.tv_sec      = modify ? modify : create;
-        st->st_atimespec.tv_nsec     = 0;
+        // Misses are reported without raising an exception
+        auto result = dos->tryAttr(path);
+        if (!result) return -FSError::posixErrno(result.error());
 
+        toStat(*result, st);
         return 0;
     });
 }
@@ -156,13 +166,11 @@ FuseVolume::open(const char *path, struct fuse_file_info *fi)
 int
 FuseVolume::read(const char *path, char *buf, size_t size, off_t offset, struct fuse_file_info* fi)
 {
-    return fsexec([&]{
+    return fsread([&]{
+
+        // Read positionally, because concurrent readers may share the handle
+        auto count = dos->pread(HandleRef(fi->fh), std::span{(u8 *)buf, size}, offset);
 
-        auto handle = HandleRef(fi->fh);
-        
-        dos->lseek(handle, offset);
-        auto count = dos->read(handle, std::span{(u8 *)buf, size});
-        
         return int(count);
     });
 }
@@ -172,11 +180,9 @@ FuseVolume::write(const char *path, const char *buf, size_t size, off_t offset,
 {
     return fsexec([&]{
 
-        auto handle = HandleRef(fi->fh);
-        
-        dos->lseek(handle, offset);
-        auto count = dos->write(handle, std::span{(u8 *)buf, size});
-        
+        // Write positionally to spare a separate seek per request
+        auto count = dos->pwrite(HandleRef(fi->fh), std::span{(const u8 *)buf, size}, offset);
+
         return int(count);
     });
 }
@@ -186,25 +192,48 @@ FuseVolume::statfs(const char *path, struct statvfs *st)
 {
     memset(st, 0, sizeof(*st));
 
-    const auto &stat = dos->stat();
-    const auto bsize = (unsigned long)stat.bsize;
-    const auto total = (fsblkcnt_t)stat.blocks;
-    const auto free  = (fsblkcnt_t)stat.freeBlocks;
+    // The free block count is computed lazily, which requires exclusive access
+    return fsexec([&]{
 
-    st->f_bsize   = bsize;          // Preferred block size
-    st->f_frsize  = bsize;          // Fundamental block size
+        const auto &stat = dos->stat();
+        const auto bsize = (unsigned long)stat.bsize;
+        const auto total = (fsblkcnt_t)stat.blocks;
+        const auto free  = (fsblkcnt_t)stat.freeBlocks;
 
-    st->f_blocks  = total;          // Total data blocks in FS
-    st->f_bfree   = free;           // Free blocks
-    st->f_bavail  = free;           // Same as bfree (no root user concept)
+        st->f_bsize   = bsize;          // Preferred block size
+        st->f_frsize  = bsize;          // Fundamental block size
 
-    st->f_fsid    = 0;              // Not required — FUSE ignores this
-    st->f_flag    = 0;              // No mount flags
-    st->f_namemax = 30;             // Amiga filename limit (OFS/FFS)
+        st->f_blocks  = total;          // Total data blocks in FS
+        st->f_bfree   = free;           // Free blocks
+        st->f_bavail  = free;           // Same as bfree (no root user concept)
 
-    printf("Free blocks: %u\n", free);
-    
-    return 0;
+        st->f_fsid    = 0;              // Not required — FUSE ignores this
+        st->f_flag    = 0;              // No mount flags
+        st->f_namemax = 30;             // Amiga filename limit (OFS/FFS)
+
+        return 0;
+    });
+}
+
+int
+FuseVolume::flush(const char *path, struct fuse_file_info *fi)
+{
+    // Called on every close(), so data is durable once the file is closed
+    return fsexec([&]{
+
+        writeBack();
+        return 0;
+    });
+}
+
+int
+FuseVolume::fsync(const char *path, int datasync, struct fuse_file_info *fi)
+{
+    return fsexec([&]{
+
+        writeBack();
+        return 0;
+    });
 }
 
 int
@@ -221,16 +250,17 @@ int
 FuseVolume::readdir(const char *path, void *buf, fuse_fill_dir_t filler,
                           off_t offset, struct fuse_file_info *fi)
 {
-    return fsexec([&]{
+    return fsread([&]{
 
         filler(buf, ".",  NULL, 0);
         filler(buf, "..", NULL, 0);
 
-        for (auto &name : dos->readDir(path)) {
-            printf("dir: %s\n", name.c_str());
-        }
-        for (auto &name : dos->readDir(path)) {
-            filler(buf, name.c_str(), NULL, 0);
+        // Hand over the attributes, too, to spare the kernel a getattr call per item
+        struct stat st;
+        for (auto &item : dos->readDirPlus(path)) {
+
+            toStat(item.attr, &st);
+            filler(buf, item.name.c_str(), &st, 0);
         }
         return 0;
     });
@@ -272,12 +302,365 @@ FuseVolume::utimens(const char *path, const struct timespec tv[2])
     return 0;
 }
 
+int
+FuseVolume::toEntry(fuse_ino_t parent, const char *name, BlockNr node, struct fuse_entry_param *e)
+{
+    auto attr = dos->tryAttr(node);
+    if (!attr) return -FSError::posixErrno(attr.error());
+
+    memset(e, 0, sizeof(*e));
+    e->ino = toIno(node);
+    e->attr_timeout = getCacheOptions().attrTimeout;
+    e->entry_timeout = getCacheOptions().entryTimeout;
+    toStat(*attr, &e->attr);
+    e->attr.st_ino = e->ino;
+
+    // The kernel holds a reference until it sends a forget request
+    dos->ref(node);
+
+    // Remember the name to be able to invalidate the kernel's entry later
+    std::lock_guard<std::mutex> guard(entryLock);
+    auto &entry = entries[e->ino];
+    entry.parent = parent;
+    entry.name = name;
+    entry.nlookup++;
+
+    return 0;
+}
+
+void
+FuseVolume::revalidate(bool force)
+{
+    // The high-level API relies on the cache timeouts
+    if (!usesLowLevelAPI()) return;
+
+    std::vector<std::pair<fuse_ino_t, KernelEntry>> stale;
+
+    {   std::unique_lock<std::shared_mutex> guard(mtx);
+
+        auto generation = dos->generation();
+        if (!force && generation == syncedGeneration) return;
+        syncedGeneration = generation;
+
+        std::lock_guard<std::mutex> entryGuard(entryLock);
+        stale.assign(entries.begin(), entries.end());
+    }
+
+    // The kernel may issue requests while processing the notifications
+    for (auto &[ino, entry] : stale) {
+
+        (void)invalidateEntry(entry.parent, entry.name);
+        (void)invalidateInode(ino);
+    }
+    (void)invalidateInode(FUSE_ROOT_ID);
+}
+
+void
+FuseVolume::ll_lookup(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    struct fuse_entry_param e;
+
+    auto err = fsread([&]{
+
+        // Misses are reported without raising an exception
+        auto node = dos->tryLookup(toNode(parent), name);
+        if (!node) {
+
+            // Let the kernel remember the miss if requested (inode 0)
+            if (node.error() == FSError::FS_NOT_FOUND && getCacheOptions().negativeTimeout > 0) {
+
+                memset(&e, 0, sizeof(e));
+                e.entry_timeout = getCacheOptions().negativeTimeout;
+                return 0;
+            }
+            return -FSError::posixErrno(node.error());
+        }
+
+        return toEntry(parent, name, *node, &e);
+    });
+
+    if (err) fuse_reply_err(req, -err); else fuse_reply_entry(req, &e);
+}
+
+void
+FuseVolume::ll_forget(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup)
+{
+    // Dropping the last reference may reclaim the node
+    fsexec([&]{
+
+        dos->forget(toNode(ino), isize(nlookup));
+
+        std::lock_guard<std::mutex> guard(entryLock);
+        if (auto it = entries.find(ino); it != entries.end()) {
+            if ((it->second.nlookup -= isize(nlookup)) <= 0) entries.erase(it);
+        }
+        return 0;
+    });
+
+    fuse_reply_none(req);
+}
+
+void
+FuseVolume::ll_getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+{
+    struct stat st;
+
+    auto err = fsread([&]{
+
+        auto attr = dos->tryAttr(toNode(ino));
+        if (!attr) return -FSError::posixErrno(attr.error());
+
+        toStat(*attr, &st);
+        st.st_ino = ino;
+        return 0;
+    });
+
+    if (err) fuse_reply_err(req, -err); else fuse_reply_attr(req, &st, getCacheOptions().attrTimeout);
+}
+
+void
+FuseVolume::ll_setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int toSet, struct fuse_file_info *fi)
+{
+    struct stat st;
+
+    auto err = fsexec([&]{
+
+        auto node = toNode(ino);
+
+        // Time stamps are ignored, like in utimens()
+        if (toSet & FUSE_SET_ATTR_MODE) dos->chmod(node, u32(attr->st_mode));
+        if (toSet & FUSE_SET_ATTR_SIZE) dos->resize(node, isize(attr->st_size));
+
+        auto result = dos->tryAttr(node);
+        if (!result) return -FSError::posixErrno(result.error());
+
+        toStat(*result, &st);
+        st.st_ino = ino;
+        return 0;
+    });
+
+    if (err) fuse_reply_err(req, -err); else fuse_reply_attr(req, &st, getCacheOptions().attrTimeout);
+}
+
+void
+FuseVolume::ll_mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode)
+{
+    struct fuse_entry_param e;
+
+    auto err = fsexec([&]{
+
+        return toEntry(parent, name, dos->mkdir(toNode(parent), name), &e);
+    });
+
+    if (err) fuse_reply_err(req, -err); else fuse_reply_entry(req, &e);
+}
+
+void
+FuseVolume::ll_unlink(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    auto err = fsexec([&]{
+
+        dos->unlink(toNode(parent), name);
+        return 0;
+    });
+
+    fuse_reply_err(req, -err);
+}
+
+void
+FuseVolume::ll_rmdir(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    auto err = fsexec([&]{
+
+        dos->rmdir(toNode(parent), name);
+        return 0;
+    });
+
+    fuse_reply_err(req, -err);
+}
+
+void
+FuseVolume::ll_rename(fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname)
+{
+    auto err = fsexec([&]{
+
+        auto node = dos->tryLookup(toNode(parent), name);
+        dos->move(toNode(parent), name, toNode(newparent), newname);
+
+        // Keep track of the new name
+        std::lock_guard<std::mutex> guard(entryLock);
+        if (auto it = node ? entries.find(toIno(*node)) : entries.end(); it != entries.end()) {
+
+            it->second.parent = newparent;
+            it->second.name = newname;
+        }
+        return 0;
+    });
+
+    fuse_reply_err(req, -err);
+}
+
+void
+FuseVolume::ll_open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+{
+    auto err = fsexec([&]{
+
+        fi->fh = (uint64_t)dos->open(toNode(ino), (u32)fi->flags);
+        return 0;
+    });
+
+    // Cached pages stay valid, because revalidate() drops them on modification
+    fi->keep_cache = getCacheOptions().kernelCache || getCacheOptions().autoCache;
+
+    if (err) fuse_reply_err(req, -err); else fuse_reply_open(req, fi);
+}
+
+void
+FuseVolume::ll_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *fi)
+{
+    std::vector<char> buf(size);
+
+    auto count = fsread([&]{
+
+        // Read positionally, because concurrent readers may share the handle
+        return int(dos->pread(HandleRef(fi->fh), std::span{(u8 *)buf.data(), size}, offset));
+    });
+
+    if (count < 0) fuse_reply_err(req, -count); else fuse_reply_buf(req, buf.data(), count);
+}
+
+void
+FuseVolume::ll_write(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+{
+    auto count = write(nullptr, buf, size, offset, fi);
+
+    if (count < 0) fuse_reply_err(req, -count); else fuse_reply_write(req, count);
+}
+
+void
+FuseVolume::ll_flush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+{
+    fuse_reply_err(req, -flush(nullptr, fi));
+}
+
+void
+FuseVolume::ll_fsync(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info *fi)
+{
+    fuse_reply_err(req, -fsync(nullptr, datasync, fi));
+}
+
+void
+FuseVolume::ll_release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+{
+    fuse_reply_err(req, -release(nullptr, fi));
+}
+
+void
+FuseVolume::ll_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *fi)
+{
+    std::vector<FSPosixDirEntry> items;
+
+    auto err = fsread([&]{
+
+        items = dos->readDirPlus(toNode(ino));
+        return 0;
+    });
+
+    if (err) { fuse_reply_err(req, -err); return; }
+
+    std::vector<char> buf(size);
+    size_t used = 0;
+
+    // Offsets 0 and 1 refer to "." and "..", all others to directory items
+    for (off_t i = offset; i < off_t(items.size()) + 2; i++) {
+
+        struct stat st;
+        const char *name;
+
+        if (i < 2) {
+
+            memset(&st, 0, sizeof(st));
+            st.st_mode = S_IFDIR;
+            st.st_ino = ino;
+            name = i == 0 ? "." : "..";
+
+        } else {
+
+            auto &item = items[i - 2];
+            toStat(item.attr, &st);
+            st.st_ino = toIno(item.node);
+            name = item.name.c_str();
+        }
+
+        // Stop if the item does not fit into the remaining space
+        auto len = fuse_add_direntry(req, buf.data() + used, size - used, name, &st, i + 1);
+        if (len > size - used) break;
+        used += len;
+    }
+
+    fuse_reply_buf(req, buf.data(), used);
+}
+
+void
+FuseVolume::ll_statfs(fuse_req_t req, fuse_ino_t ino)
+{
+    struct statvfs st;
+
+    auto err = statfs(nullptr, &st);
+    if (err) fuse_reply_err(req, -err); else fuse_reply_statfs(req, &st);
+}
+
+void
+FuseVolume::ll_create(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, struct fuse_file_info *fi)
+{
+    struct fuse_entry_param e;
+
+    auto err = fsexec([&]{
+
+        auto node = dos->create(toNode(parent), name);
+        fi->fh = (uint64_t)dos->open(node, (u32)fi->flags);
+        fi->keep_cache = getCacheOptions().kernelCache || getCacheOptions().autoCache;
+        return toEntry(parent, name, node, &e);
+    });
+
+    if (err) fuse_reply_err(req, -err); else fuse_reply_create(req, &e, fi);
+}
+
 FSPosixStat
 FuseVolume::stat()
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     return dos->stat();
 }
 
+void
+FuseVolume::writeBack()
+{
+    // Remember the write-back, because the image file needs saving afterwards
+    if (dos->stat().dirtyBlocks > 0) {
+
+        dos->flush();
+        device.dirty = true;
+    }
+}
+
+void
+FuseVolume::flush()
+{
+    std::unique_lock<std::shared_mutex> guard(mtx);
+    dos->flush();
+}
+
+void
+FuseVolume::invalidate()
+{
+    // Keep FUSE requests out while the cached blocks are freed
+    {   std::unique_lock<std::shared_mutex> guard(mtx);
+        dos->invalidate();
+    }
+    revalidate(true);
+}
+
 void
 FuseVolume::push()
 {
@@ -320,12 +703,14 @@ FuseAmigaVolume::typeOf(isize blockNr, isize pos) const
 void
 FuseAmigaVolume::xrayBitmap(bool strict)
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.xrayBitmap(strict);
 }
 
 void
 FuseAmigaVolume::xray(bool strict)
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.xray(strict);
 }
 
@@ -334,6 +719,7 @@ FuseAmigaVolume::xray(isize blockNr, isize pos, bool strict, optional<u8> &expec
 {
     using amiga::FSBlockError;
     
+    std::unique_lock<std::shared_mutex> guard(mtx);
     auto error = fs->doctor.xray8(BlockNr(blockNr), pos, strict, expected);
     
     switch (error) {
@@ -394,33 +780,58 @@ FuseAmigaVolume::unusedButAllocated() const
 void
 FuseAmigaVolume::rectifyAllocationMap(bool strict)
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.rectifyBitmap(strict);
 }
 
 void
 FuseAmigaVolume::rectify(bool strict)
 {
-    fs->doctor.rectify(strict);
+    // Keep FUSE requests out while the doctor rewrites blocks
+    {   std::unique_lock<std::shared_mutex> guard(mtx);
+        fs->doctor.rectify(strict);
+    }
+    revalidate();
 }
 
 void
 FuseAmigaVolume::createUsageMap(u8 *buf, isize len) const
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.createUsageMap(buf, len);
 }
 
 void
 FuseAmigaVolume::createAllocationMap(u8 *buf, isize len) const
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.createAllocationMap(buf, len);
 }
 
 void
 FuseAmigaVolume::createHealthMap(u8 *buf, isize len) const
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.createHealthMap(buf, len);
 }
 
+isize
+FuseAmigaVolume::getCacheBudget() const
+{
+    std::shared_lock<std::shared_mutex> guard(mtx);
+    return fs->getCacheBudget();
+}
+
+void
+FuseAmigaVolume::setCacheBudget(isize bytes)
+{
+    std::unique_lock<std::shared_mutex> guard(mtx);
+    fs->setCacheBudget(bytes);
+
+    // Shrink the cache right away if the budget has been lowered
+    if (fs->exceedsCacheBudget()) fs->trim();
+}
+
 
 //
 // CBM volume
@@ -454,12 +865,14 @@ FuseCBMVolume::typeOf(isize blockNr, isize pos) const
 void
 FuseCBMVolume::xrayBitmap(bool strict)
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.xrayBitmap(strict);
 }
 
 void
 FuseCBMVolume::xray(bool strict)
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.xray(strict);
 }
 
@@ -468,6 +881,7 @@ FuseCBMVolume::xray(isize blockNr, isize pos, bool strict, optional<u8> &expecte
 {
     using cbm::FSBlockError;
     
+    std::unique_lock<std::shared_mutex> guard(mtx);
     auto error = fs->doctor.xray8(BlockNr(blockNr), pos, strict, expected);
     
     switch (error) {
@@ -506,29 +920,37 @@ FuseCBMVolume::unusedButAllocated() const
 void
 FuseCBMVolume::rectifyAllocationMap(bool strict)
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.rectifyBitmap(strict);
 }
 
 void
 FuseCBMVolume::rectify(bool strict)
 {
-    fs->doctor.rectify(strict);
+    // Keep FUSE requests out while the doctor rewrites blocks
+    {   std::unique_lock<std::shared_mutex> guard(mtx);
+        fs->doctor.rectify(strict);
+    }
+    revalidate();
 }
 
 void
 FuseCBMVolume::createUsageMap(u8 *buf, isize len) const
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.createUsageMap(buf, len);
 }
 
 void
 FuseCBMVolume::createAllocationMap(u8 *buf, isize len) const
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.createAllocationMap(buf, len);
 }
 
 void
 FuseCBMVolume::createHealthMap(u8 *buf, isize len) const
 {
+    std::unique_lock<std::shared_mutex> guard(mtx);
     fs->doctor.createHealthMap(buf, len);
 }
@@ -16,6 +16,7 @@
 #include "FileSystems/PosixView.h"
 #include "FileSystems/Amiga/FileSystem.h"
 #include "FileSystems/CBM/FileSystem.h"
+#include <shared_mutex>
 
 using namespace retro::vault;
 
@@ -35,8 +36,25 @@ protected:
     // POSIX layer on top of the raw file system
     unique_ptr<PosixView> dos;
 
-    // Synchronization lock
-    std::mutex mtx;
+    // Synchronization lock (shared by readers, exclusive for all other operations)
+    mutable std::shared_mutex mtx;
+
+    // Directory entry handed to the kernel
+    struct KernelEntry {
+
+        fuse_ino_t parent;
+        string name;
+        isize nlookup;
+    };
+
+    // All directory entries the kernel may have cached (low-level API only)
+    std::unordered_map<fuse_ino_t, KernelEntry> entries;
+
+    // Serializes updates of the entry table (lookups run in parallel)
+    std::mutex entryLock;
+
+    // File system generation the kernel caches are consistent with
+    isize syncedGeneration = 0;
 
 public:
 
@@ -54,7 +72,9 @@ public:
     FUSE_READ     override;
     FUSE_WRITE    override;
     FUSE_STATFS   override;
+    FUSE_FLUSH    override;
     FUSE_RELEASE  override;
+    FUSE_FSYNC    override;
     FUSE_READDIR  override;
     FUSE_INIT     override;
     FUSE_DESTROY  override;
@@ -62,6 +82,24 @@ public:
     FUSE_CREATE   override;
     FUSE_UTIMENS  override;
 
+    FUSE_LL_LOOKUP  override;
+    FUSE_LL_FORGET  override;
+    FUSE_LL_GETATTR override;
+    FUSE_LL_SETATTR override;
+    FUSE_LL_MKDIR   override;
+    FUSE_LL_UNLINK  override;
+    FUSE_LL_RMDIR   override;
+    FUSE_LL_RENAME  override;
+    FUSE_LL_OPEN    override;
+    FUSE_LL_READ    override;
+    FUSE_LL_WRITE   override;
+    FUSE_LL_FLUSH   override;
+    FUSE_LL_RELEASE override;
+    FUSE_LL_FSYNC   override;
+    FUSE_LL_READDIR override;
+    FUSE_LL_STATFS  override;
+    FUSE_LL_CREATE  override;
+
     Volume &getVolume() { return *vol; }
     
     virtual vector<string> describe() const noexcept = 0;
@@ -95,17 +133,72 @@ public:
     bool isWriteProtected() { return dos->isWriteProtected(); }
     void writeProtect(bool yesno) { dos->writeProtect(yesno); }
 
+    // Limits the memory consumed by the block cache (0 = unlimited)
+    virtual isize getCacheBudget() const { return 0; }
+    virtual void setCacheBudget(isize bytes) { }
+
     // Writes all changes back to the image file
     void push();
     
-    void flush() { dos->flush(); }
-    void invalidate() { dos->invalidate(); }
+    // Writes all dirty blocks back to the volume
+    void flush();
+
+    // Discards all cached blocks (call if the volume was modified directly)
+    void invalidate();
+
+    // Makes the kernel drop cached data if the file system was modified
+    // outside of FUSE (pass true if the modification bypassed the file system)
+    void revalidate(bool force = false);
     
 protected:
 
+    // Translates file attributes into a stat structure
+    static void toStat(const FSPosixAttr &attr, struct stat *st);
+
+    // Translates between file system nodes and FUSE inode numbers
+    fuse_ino_t toIno(BlockNr node) const { return node == dos->root() ? FUSE_ROOT_ID : fuse_ino_t(node) + 2; }
+    BlockNr toNode(fuse_ino_t ino) const { return ino == FUSE_ROOT_ID ? dos->root() : BlockNr(ino) - 2; }
+
+    // Writes dirty blocks back to the volume and marks the device as modified
+    void writeBack();
+
+    // Fills in a directory entry and registers the lookup
+    int toEntry(fuse_ino_t parent, const char *name, BlockNr node, struct fuse_entry_param *e);
+
+    // Runs an operation with exclusive access to the file system
     template <typename Fn> int fsexec(Fn &&fn) {
 
-        std::lock_guard<std::mutex> guard(mtx);
+        std::unique_lock<std::shared_mutex> guard(mtx);
+        auto before = dos->generation();
+        auto result = fscatch(fn);
+
+        // Changes made through FUSE are known to the kernel, others are not
+        if (syncedGeneration == before) syncedGeneration = dos->generation();
+        return result;
+    }
+
+    // Runs a read-only operation in parallel with other readers
+    template <typename Fn> int fsread(Fn &&fn) {
+
+        // Fall back to exclusive access if the file system is not thread-safe
+        if (!dos->allowsConcurrentReads()) return fsexec(fn);
+
+        int result;
+        bool trim;
+        {   std::shared_lock<std::shared_mutex> guard(mtx);
+
+            result = fscatch(fn);
+            trim = dos->needsTrim();
+        }
+
+        // Readers must not evict blocks other readers may still reference
+        if (trim) fsexec([&]{ dos->trim(); return 0; });
+
+        return result;
+    }
+
+    // Translates exceptions into POSIX error codes
+    template <typename Fn> int fscatch(Fn &&fn) {
 
         try {
 
@@ -155,6 +248,9 @@ public:
     void createUsageMap(u8 *buf, isize len) const override;
     void createAllocationMap(u8 *buf, isize len) const override;
     void createHealthMap(u8 *buf, isize len) const override;
+
+    isize getCacheBudget() const override;
+    void setCacheBudget(isize bytes) override;
 };
 
 class FuseCBMVolume : public FuseVolume {
@@ -138,6 +138,17 @@ inline const char *c_str(const std::string &s)
 -(void)toggleWriteProtection:(NSInteger)v;
 -(void)writeProtect:(BOOL)wp volume:(NSInteger)v;
 
+-(NSInteger)workers:(NSInteger)v;
+-(void)setWorkers:(NSInteger)count volume:(NSInteger)v;
+-(BOOL)usesLowLevelAPI:(NSInteger)v;
+-(void)useLowLevelAPI:(BOOL)yesno volume:(NSInteger)v;
+-(FuseCacheOptions)cacheOptions:(NSInteger)v;
+-(void)setCacheOptions:(FuseCacheOptions)options volume:(NSInteger)v;
+-(FuseTransferOptions)transferOptions:(NSInteger)v;
+-(void)setTransferOptions:(FuseTransferOptions)options volume:(NSInteger)v;
+-(NSInteger)cacheBudget:(NSInteger)v;
+-(void)setCacheBudget:(NSInteger)bytes volume:(NSInteger)v;
+
 
 //
 // Querying block properties
@@ -153,6 +153,56 @@ using namespace utl;
     [self volume:v].writeProtect(wp);
 }
 
+- (NSInteger)workers:(NSInteger)v
+{
+    return [self volume:v].getWorkers();
+}
+
+- (void)setWorkers:(NSInteger)count volume:(NSInteger)v
+{
+    [self volume:v].setWorkers(int(count));
+}
+
+- (BOOL)usesLowLevelAPI:(NSInteger)v
+{
+    return [self volume:v].usesLowLevelAPI();
+}
+
+- (void)useLowLevelAPI:(BOOL)yesno volume:(NSInteger)v
+{
+    [self volume:v].useLowLevelAPI(yesno);
+}
+
+- (FuseCacheOptions)cacheOptions:(NSInteger)v
+{
+    return [self volume:v].getCacheOptions();
+}
+
+- (void)setCacheOptions:(FuseCacheOptions)options volume:(NSInteger)v
+{
+    [self volume:v].setCacheOptions(options);
+}
+
+- (FuseTransferOptions)transferOptions:(NSInteger)v
+{
+    return [self volume:v].getTransferOptions();
+}
+
+- (void)setTransferOptions:(FuseTransferOptions)options volume:(NSInteger)v
+{
+    [self volume:v].setTransferOptions(options);
+}
+
+- (NSInteger)cacheBudget:(NSInteger)v
+{
+    return [self volume:v].getCacheBudget();
+}
+
+- (void)setCacheBudget:(NSInteger)bytes volume:(NSInteger)v
+{
+    [self volume:v].setCacheBudget(bytes);
+}
+
 - (NSArray<NSString *> *)blockTypes:(NSInteger)v
 {
     const auto vec = [self volume:v].blockTypes();
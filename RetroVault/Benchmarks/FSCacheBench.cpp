@@ -0,0 +1,109 @@
+// -----------------------------------------------------------------------------
+// This file is part of RetroVault
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the Mozilla Public License v2
+//
+// See https://mozilla.org/MPL/2.0 for license information
+// -----------------------------------------------------------------------------
+
+/* Microbenchmark of the Amiga block cache. It fetches every block of a
+ * freshly formatted hard drive image twice (cold misses first, warm hits
+ * second) and compares the block table with the hash map based lookup that
+ * FSCache::cache() used before. The reference path reproduces the old code:
+ * one heap allocated FSBlock and one heap allocated payload per miss, found
+ * through an unordered_map.
+ *
+ * Usage: FSCacheBench [image size in MB] (default: 256)
+ */
+
+#include "config.h"
+#include "HDFFile.h"
+#include "Volume.h"
+#include "FileSystems/Amiga/FileSystem.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
+
+using namespace retro::vault;
+using namespace retro::vault::amiga;
+
+using Clock = std::chrono::steady_clock;
+
+// Cache entry of the old implementation
+struct LegacyEntry {
+
+    std::unique_ptr<FSBlock> block;
+    Buffer<u8> payload;
+};
+
+// Block lookup as performed by the old FSCache::cache()
+struct LegacyCache {
+
+    const FileSystem &fs;
+    const Volume &dev;
+    isize bsize;
+
+    std::unordered_map<BlockNr, std::unique_ptr<LegacyEntry>> blocks;
+
+    const FSBlock *cache(BlockNr nr) {
+
+        auto [it, inserted] = blocks.try_emplace(nr, nullptr);
+        if (!inserted) return it->second->block.get();
+
+        auto entry = std::make_unique<LegacyEntry>();
+        entry->block = std::make_unique<FSBlock>(const_cast<FileSystem *>(&fs), nr);
+        entry->payload.alloc(bsize);
+
+        dev.readBlock(entry->payload.ptr, nr);
+        entry->block->type = fs.predictType(nr, entry->payload.ptr);
+
+        it->second = std::move(entry);
+        return it->second->block.get();
+    }
+};
+
+template <typename Fn> static double
+measure(isize blocks, Fn &&fn)
+{
+    auto start = Clock::now();
+    for (isize i = 0; i < blocks; i++) fn(BlockNr(i));
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+
+    return elapsed.count() / double(blocks);
+}
+
+int main(int argc, char *argv[])
+{
+    isize mb = argc > 1 ? std::atol(argv[1]) : 256;
+
+    image::HDFFile hdf(mb * 1024 * 1024);
+    Volume vol(hdf);
+    FileSystem fs(vol);
+    fs.format(FSFormat::FFS);
+    fs.flush();
+
+    auto blocks = fs.blocks();
+    isize sink = 0;
+
+    printf("Fetching %ld blocks of a %ld MB FFS volume\n\n", long(blocks), long(mb));
+    printf("%-12s %14s %14s\n", "", "cold (ns/blk)", "warm (ns/blk)");
+
+    {   LegacyCache legacy { fs, vol, fs.bsize() };
+
+        auto cold = measure(blocks, [&](BlockNr nr) { sink += isize(legacy.cache(nr)->type); });
+        auto warm = measure(blocks, [&](BlockNr nr) { sink += isize(legacy.cache(nr)->type); });
+        printf("%-12s %14.1f %14.1f\n", "hash map", cold, warm);
+    }
+    {   fs.invalidate();
+
+        auto cold = measure(blocks, [&](BlockNr nr) { sink += isize(fs.fetch(nr).type); });
+        auto warm = measure(blocks, [&](BlockNr nr) { sink += isize(fs.fetch(nr).type); });
+        printf("%-12s %14.1f %14.1f\n", "block table", cold, warm);
+    }
+
+    // Consume the results so that the lookups are not optimized away
+    return sink < 0;
+}
@@ -0,0 +1,151 @@
+// -----------------------------------------------------------------------------
+// This file is part of RetroVault
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the Mozilla Public License v2
+//
+// See https://mozilla.org/MPL/2.0 for license information
+// -----------------------------------------------------------------------------
+
+/* Checks and benchmarks the block checksum kernels. All kernels compiled
+ * into this executable are compared with a plain byte-by-byte loop for
+ * various lengths and alignments. Afterwards, each kernel is timed on
+ * 512-byte blocks. The exit code is nonzero if a kernel is incorrect.
+ *
+ * Usage: FSChecksumBench [iterations] (default: 1000000)
+ */
+
+#include "config.h"
+#include "FileSystems/Amiga/FSChecksum.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace retro::vault::amiga;
+
+using Clock = std::chrono::steady_clock;
+
+struct Kernel {
+
+    const char *name;
+    u32 (*sum32)(const u8 *, isize);
+    u64 (*sum64)(const u8 *, isize);
+};
+
+static const Kernel kernels[] = {
+
+    { "scalar", FSChecksum::sum32Scalar, FSChecksum::sum64Scalar },
+#ifdef FS_CHECKSUM_SSE2
+    { "SSE2",   FSChecksum::sum32SSE2,   FSChecksum::sum64SSE2 },
+#endif
+#ifdef FS_CHECKSUM_AVX2
+    { "AVX2",   FSChecksum::sum32AVX2,   FSChecksum::sum64AVX2 },
+#endif
+#ifdef FS_CHECKSUM_NEON
+    { "NEON",   FSChecksum::sum32NEON,   FSChecksum::sum64NEON },
+#endif
+    { "default", FSChecksum::sum32,      FSChecksum::sum64 },
+};
+
+// Reference implementation
+static u64
+reference(const u8 *p, isize count)
+{
+    u64 result = 0;
+
+    for (isize i = 0; i < count; i++, p += 4) {
+        result += u64(p[0]) << 24 | u64(p[1]) << 16 | u64(p[2]) << 8 | u64(p[3]);
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    isize iterations = argc > 1 ? std::atol(argv[1]) : 1000000;
+
+#if defined(FS_CHECKSUM_AVX2) && (defined(__GNUC__) || defined(__clang__))
+    if (!__builtin_cpu_supports("avx2")) {
+
+        printf("This CPU does not support AVX2\n");
+        return 0;
+    }
+#endif
+
+    std::mt19937 rng(42);
+    std::vector<u8> buffer(4 * 1024 * 1024 + 64);
+    for (auto &byte : buffer) byte = u8(rng());
+
+    //
+    // Correctness
+    //
+
+    isize errors = 0;
+
+    for (auto &kernel : kernels) {
+        for (isize offset = 0; offset < 4; offset++) {
+            for (isize count = 0; count <= 300; count++) {
+
+                auto *p = buffer.data() + offset;
+                auto expected = reference(p, count);
+
+                if (kernel.sum32(p, count) != u32(expected) || kernel.sum64(p, count) != expected) {
+
+                    printf("%s: Mismatch (offset %ld, %ld long words)\n",
+                           kernel.name, long(offset), long(count));
+                    errors++;
+                }
+            }
+        }
+    }
+
+    // Large inputs overflow 32 bit and exercise the 64-bit accumulators
+    for (auto &kernel : kernels) {
+
+        auto count = isize(buffer.size() - 64) / 4;
+        if (kernel.sum64(buffer.data(), count) != reference(buffer.data(), count)) {
+
+            printf("%s: Mismatch (%ld long words)\n", kernel.name, long(count));
+            errors++;
+        }
+    }
+
+    printf("%s\n\n", errors ? "Kernels are INCORRECT" : "All kernels match the reference");
+
+    //
+    // Performance
+    //
+
+    constexpr isize bsize = 512;
+    constexpr isize count = bsize / 4;
+    const isize blocks = isize(buffer.size() - 64) / bsize;
+
+    printf("%-8s %16s %16s\n", "", "sum32 (ns/blk)", "sum64 (ns/blk)");
+
+    u64 sink = 0;
+
+    for (auto &kernel : kernels) {
+
+        double ns[2];
+
+        for (isize k = 0; k < 2; k++) {
+
+            auto start = Clock::now();
+            for (isize i = 0; i < iterations; i++) {
+
+                auto *p = buffer.data() + (i % blocks) * bsize;
+                sink += k == 0 ? kernel.sum32(p, count) : kernel.sum64(p, count);
+            }
+            ns[k] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            ns[k] /= double(iterations);
+        }
+
+        printf("%-8s %16.1f %16.1f\n", kernel.name, ns[0], ns[1]);
+    }
+
+    // Consume the results so that the kernels are not optimized away
+    if (sink == 42) printf("\n");
+
+    return errors ? 1 : 0;
+}
@@ -35,6 +35,20 @@ BlockDevice::writeBlocks(const u8 *src, Range<isize> range)
         write(src, range.lower * bsize(), range.size() * bsize());
 }
 
+void
+BlockDevice::eraseBlocks(Range<isize> range)
+{
+    assert(range.subset(Range<isize>(0, capacity())));
+
+    // Write zeroes in chunks to keep the buffer small
+    constexpr isize chunkSize = 64;
+    std::vector<u8> zeroes(std::min(range.size(), chunkSize) * bsize());
+
+    for (isize nr = range.lower; nr < range.upper; nr += chunkSize) {
+        writeBlocks(zeroes.data(), Range{nr, std::min(nr + chunkSize, range.upper)});
+    }
+}
+
 void
 BlockDevice::readBlock(span<u8> dst, isize nr) const
 {
@@ -36,10 +36,16 @@ public:
     virtual void writeBlock(const u8 *src, isize nr) { writeBlocks(src, Range{nr,nr+1}); };
     virtual void writeBlocks(const  u8 *src, Range<isize> range);
 
+    // Overwrites a range of blocks with zeroes
+    virtual void eraseBlocks(Range<isize> range);
+
     // Safety wrappers
     void readBlock(span<u8> dst, isize nr) const;
     void writeBlock(span<const u8> src, isize nr);
 
+    // Provides direct access to the data of a block (nullptr if unsupported)
+    virtual u8 *mapBlock(isize nr) noexcept { return nullptr; }
+
     // Exports a single block or a block range to a file
     void exportBlock(const fs::path& path, isize nr) const;
     void exportBlocks(const fs::path& path, Range<isize> range) const;
@@ -69,4 +69,24 @@ Volume::writeBlocks(const u8 *src, Range<isize> r)
     }
 }
 
+void
+Volume::eraseBlocks(Range<isize> r)
+{
+    auto mappedLower = range.translate(r.lower);
+    auto mappedRange = Range<isize> { mappedLower, mappedLower + r.size() };
+
+    if (auto size = mappedRange.size(); size > 0) {
+
+        writes += size * bsize();
+        device.eraseBlocks(mappedRange);
+    }
+}
+
+u8 *
+Volume::mapBlock(isize nr) noexcept
+{
+    if (nr < 0 || nr >= range.size()) return nullptr;
+    return device.mapBlock(range.translate(nr));
+}
+
 }
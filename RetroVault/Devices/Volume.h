@@ -12,6 +12,7 @@
 #include "BlockDevice.h"
 #include "DeviceDescriptors.h"
 #include "utl/primitives.h"
+#include <atomic>
 
 namespace retro::vault {
 
@@ -26,8 +27,8 @@ class Volume : public BlockDevice {
 public:
 
     // Access statistics (transferred bytes)
-    mutable i64 reads = 0;
-    mutable i64 writes = 0;
+    mutable std::atomic<i64> reads = 0;
+    mutable std::atomic<i64> writes = 0;
 
 
     //
@@ -64,6 +65,8 @@ public:
     isize bsize() const override { return device.bsize(); }
     void readBlocks(u8 *dst, Range<isize> range) const override;
     void writeBlocks(const u8 *src, Range<isize> range) override;
+    void eraseBlocks(Range<isize> range) override;
+    u8 *mapBlock(isize nr) noexcept override;
 };
 
 }
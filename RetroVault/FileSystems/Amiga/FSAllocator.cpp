@@ -56,35 +56,23 @@ FSAllocator::requiredBlocks(isize fileSize) const noexcept
 bool
 FSAllocator::allocatable(isize count) const noexcept
 {
-    BlockNr i = ap;
-    isize capacity = fs.blocks();
-
-    while (count > 0) {
-
-        if (fs.isEmpty(i)) {
-            if (--count == 0) break;
-        }
-
-        i = (i + 1) % capacity;
-        if (i == ap) return false;
-    }
+    if (count <= 0) return true;
 
-    return true;
+    // The counter is maintained by all bitmap updates
+    getFreeMap();
+    return freeCount >= count;
 }
 
 BlockNr
 FSAllocator::allocate()
 {
     auto numBlocks = fs.blocks();
-    BlockNr i = ap;
-
-    while (!fs.isEmpty(i)) {
+    BlockNr i = findFree(ap);
 
-        if ((i = (i + 1) % numBlocks) == ap) {
+    if (i < 0) {
 
-            loginfo(FS_DEBUG, "No more free blocks\n");
-            throw FSError(FSError::FS_OUT_OF_SPACE);
-        }
+        loginfo(FS_DEBUG, "No more free blocks\n");
+        throw FSError(FSError::FS_OUT_OF_SPACE);
     }
 
     fs.fetch(i).mutate().init(FSBlockType::UNKNOWN);
@@ -116,54 +104,151 @@ FSAllocator::allocate(isize count, std::vector<BlockNr> &result, std::vector<Blo
     // Step 1: Use pre-allocated blocks first
     while (!prealloc.empty() && count > 0) {
 
+        markAsAllocated(prealloc.back());
         result.push_back(prealloc.back());
         prealloc.pop_back();
         count--;
     }
 
-    // Step 2: Allocate remaining blocks from free space
+    // Step 2: Fail early if the remaining blocks cannot be allocated
+    if (!allocatable(count)) {
+
+        loginfo(FS_DEBUG, "No more free blocks\n");
+        throw FSError(FSError::FS_OUT_OF_SPACE);
+    }
+
+    // Step 3: Allocate remaining blocks from free space
     BlockNr i = ap;
     while (count > 0) {
 
-        if (fs.isEmpty(i)) {
+        i = findFree(i);
+        assert(i >= 0);
 
-            fs.fetch(i).mutate().type = FSBlockType::UNKNOWN;
-            result.push_back(i);
-            count--;
-        }
+        fs.fetch(i).mutate().type = FSBlockType::UNKNOWN;
+        markAsAllocated(i);
+        result.push_back(i);
+        count--;
 
         // Move to the next block
         i = (i + 1) % fs.blocks();
+    }
+
+    // Step 4: Advance allocation pointer
+    ap = i;
+}
+
+std::vector<Range<BlockNr>>
+FSAllocator::allocateExtents(isize count)
+{
+    std::vector<Range<BlockNr>> result;
 
-        // Fail if we looped all the way and still need blocks
-        if (i == ap && count > 0) {
+    if (count <= 0) return result;
+
+    if (!allocatable(count)) {
+
+        loginfo(FS_DEBUG, "No more free blocks\n");
+        throw FSError(FSError::FS_OUT_OF_SPACE);
+    }
 
-            loginfo(FS_DEBUG, "No more free blocks\n");
-            throw FSError(FSError::FS_OUT_OF_SPACE);
+    // Step 1: Search a single run
+    if (auto run = findRun(count)) {
+
+        result.push_back(*run);
+
+    } else {
+
+        // Step 2: Fall back to the largest runs, which minimizes the run count
+        auto runs = freeRuns();
+        std::ranges::stable_sort(runs, std::greater{}, [](auto &run) { return run.size(); });
+
+        for (auto &run : runs) {
+
+            auto size = std::min(count, run.size());
+            result.push_back({ run.lower, run.lower + size });
+            if ((count -= size) == 0) break;
         }
+
+        std::ranges::sort(result, {}, [](auto &run) { return run.lower; });
     }
 
     // Step 3: Mark all blocks as allocated
-    for (const auto &b : result) markAsAllocated(b);
+    claim(result);
 
-    // Step 4: Advance allocation pointer
-    ap = i;
+    loginfo(FS_DEBUG, "Allocated %ld extents\n", result.size());
+    return result;
+}
+
+optional<Range<BlockNr>>
+FSAllocator::allocateRun(isize count)
+{
+    if (count <= 0 || !allocatable(count)) return {};
+
+    auto result = findRun(count);
+    if (result) claim({ *result });
+
+    return result;
+}
+
+void
+FSAllocator::claim(const std::vector<Range<BlockNr>> &runs)
+{
+    if (runs.empty()) return;
+
+    for (auto &run : runs) {
+        for (BlockNr i = run.lower; i < run.upper; i++) fs.fetch(i).mutate().type = FSBlockType::UNKNOWN;
+    }
+    setAllocRanges(runs, 0);
+
+    // Advance the allocation pointer
+    ap = runs.back().upper % fs.blocks();
+}
+
+BlockNr
+FSAllocator::nearestFree(BlockNr nr) const
+{
+    auto &map = getFreeMap();
+    auto numBlocks = fs.blocks();
+
+    if (nr < 0 || nr >= numBlocks) return -1;
+
+    // Search upwards
+    BlockNr up = -1;
+    for (BlockNr i = nr; i < numBlocks; i = (i / 64 + 1) * 64) {
+
+        if (u64 word = map[i / 64] & (~u64(0) << (i % 64))) {
+            up = (i / 64) * 64 + std::countr_zero(word); break;
+        }
+    }
+
+    // Search downwards
+    BlockNr down = -1;
+    for (BlockNr i = nr; i >= 0; i = (i / 64) * 64 - 1) {
+
+        auto shift = 63 - i % 64;
+        if (u64 word = map[i / 64] << shift) {
+            down = i - std::countl_zero(word); break;
+        }
+    }
+
+    if (up < 0) return down;
+    if (down < 0) return up;
+    return up - nr <= nr - down ? up : down;
 }
 
 void
 FSAllocator::deallocateBlock(BlockNr nr)
 {
-    fs.fetch(nr).mutate().init(FSBlockType::EMPTY);
-    markAsFree(nr);
+    deallocateBlocks({ nr });
 }
 
 void
 FSAllocator::deallocateBlocks(const std::vector<BlockNr> &nrs)
 {
-    for (BlockNr nr : nrs) { deallocateBlock(nr); }
+    for (BlockNr nr : nrs) { fs.fetch(nr).mutate().init(FSBlockType::EMPTY); }
+    markAsFree(nrs);
 }
 
-void
+isize
 FSAllocator::allocateFileBlocks(isize bytes,
                                 std::vector<BlockNr> &listBlocks,
                                 std::vector<BlockNr> &dataBlocks)
@@ -177,15 +262,17 @@ FSAllocator::allocateFileBlocks(isize bytes,
         a file of the given size. If the caller provided more blocks than needed,
         the surplus blocks are freed. If fewer blocks are provided, new blocks
         are allocated and appended to the respective lists.
+
+        New blocks are reserved upfront in as few contiguous runs as possible
+        and handed out in ascending order. Hence, a file that fits into a
+        single free run is stored contiguously in the order it is read.
     */
 
     auto freeSurplus = [&](std::vector<BlockNr> &blocks, usize count) {
 
         if (blocks.size() > count) {
 
-            for (auto i = count; i < blocks.size(); i++) {
-                deallocateBlock(blocks[i]);
-            }
+            deallocateBlocks(std::vector<BlockNr>(blocks.begin() + count, blocks.end()));
             blocks.resize(count);
 
         } else {
@@ -194,18 +281,45 @@ FSAllocator::allocateFileBlocks(isize bytes,
         }
     };
 
-    usize dataBlocksNeeded = 0;
+    isize numDataBlocks = requiredDataBlocks(bytes);
+    isize numListBlocks = requiredFileListBlocks(bytes);
+
+    // Free the surplus blocks
+    freeSurplus(listBlocks, numListBlocks);
+    freeSurplus(dataBlocks, numDataBlocks);
+
+    // Allocate the missing blocks
+    allocateFileBlocks(bytes, isize(listBlocks.size()), isize(dataBlocks.size()), listBlocks, dataBlocks);
+
+    // Report fragmentation
+    std::vector<BlockNr> all = dataBlocks;
+    all.insert(all.end(), listBlocks.begin(), listBlocks.end());
+    auto extents = isize(Range<BlockNr>::coalesce(all).size());
+    loginfo(FS_DEBUG, "              File extents : %ld\n", extents);
+
+    return extents;
+}
+
+void
+FSAllocator::allocateFileBlocks(isize bytes, isize ownedListBlocks, isize ownedDataBlocks,
+                                std::vector<BlockNr> &listBlocks,
+                                std::vector<BlockNr> &dataBlocks)
+{
+    std::vector<BlockNr> pool;
+    usize poolIndex = 0;
+
+    isize dataBlocksNeeded = 0;
     auto ensureDataBlocks = [&](isize n) {
 
         dataBlocksNeeded += n;
-        while (dataBlocks.size() < dataBlocksNeeded) allocate(1, dataBlocks);
+        for (; ownedDataBlocks < dataBlocksNeeded; ownedDataBlocks++) dataBlocks.push_back(pool[poolIndex++]);
     };
 
-    usize listBlocksNeeded = 0;
+    isize listBlocksNeeded = 0;
     auto ensureListBlocks = [&](isize n) {
 
         listBlocksNeeded += n;
-        while (listBlocks.size() < listBlocksNeeded) allocate(1, listBlocks);
+        for (; ownedListBlocks < listBlocksNeeded; ownedListBlocks++) listBlocks.push_back(pool[poolIndex++]);
     };
 
     isize numDataBlocks         = requiredDataBlocks(bytes);
@@ -223,9 +337,12 @@ FSAllocator::allocateFileBlocks(isize bytes,
     loginfo(FS_DEBUG, "    References in list blocks : %ld\n", refsInListBlocks);
     loginfo(FS_DEBUG, "References in last list block : %ld\n", refsInLastListBlock);
 
-    // Free the surplus list blocks
-    freeSurplus(listBlocks, numListBlocks);
-    freeSurplus(dataBlocks, numDataBlocks);
+    // Reserve all missing blocks
+    isize missing = std::max(numListBlocks - ownedListBlocks, isize(0)) +
+                    std::max(numDataBlocks - ownedDataBlocks, isize(0));
+    for (auto &run : allocateExtents(missing)) {
+        for (BlockNr i = run.lower; i < run.upper; i++) pool.push_back(i);
+    }
 
     if (traits.ofs()) {
 
@@ -235,7 +352,7 @@ FSAllocator::allocateFileBlocks(isize bytes,
         for (isize i = 0; i < numListBlocks; i++) {
 
             ensureListBlocks(1);
-            ensureDataBlocks(i < numListBlocks - 1 ? refsPerBlock : refsInLastListBlock);
+            ensureDataBlocks(std::min(refsPerBlock, refsInListBlocks - i * refsPerBlock));
         }
     }
 
@@ -247,9 +364,7 @@ FSAllocator::allocateFileBlocks(isize bytes,
         ensureDataBlocks(refsInListBlocks);
     }
 
-    // Rectify checksums
-    for (auto &it : fs.getBmBlocks()) fs[it].mutate().updateChecksum();
-    for (auto &it : fs.getBmExtBlocks()) fs[it].mutate().updateChecksum();
+    assert(poolIndex == pool.size());
 }
 
 bool
@@ -329,15 +444,19 @@ FSAllocator::locateAllocationBit(BlockNr nr, isize *byte, isize *bit) const noex
 isize
 FSAllocator::numUnallocated() const noexcept
 {
-    isize result = 0;
-    for (auto &it : readBitmap()) result += std::popcount(it);
+    getFreeMap();
+    isize result = freeCount;
 
     if constexpr (debug::FS_DEBUG) {
 
+        isize scan = 0;
+        for (auto &it : readBitmap()) scan += std::popcount(it);
+
         isize count = 0;
         for (isize i = 0; i < fs.blocks(); i++) { if (isUnallocated(BlockNr(i))) count++; }
-        loginfo(FS_DEBUG, "Unallocated blocks: Fast code: %ld Slow code: %ld\n", result, count);
+        loginfo(FS_DEBUG, "Unallocated blocks: Counter: %ld Scan: %ld Slow code: %ld\n", result, scan, count);
         assert(count == result);
+        assert(scan == result);
     }
 
     return result;
@@ -382,6 +501,103 @@ FSAllocator::readBitmap() const
     return result;
 }
 
+BlockNr
+FSAllocator::scan(BlockNr nr, bool value) const
+{
+    auto &map = getFreeMap();
+    auto numBlocks = fs.blocks();
+
+    while (nr < numBlocks) {
+
+        u64 word = value ? map[nr / 64] : ~map[nr / 64];
+        word &= ~u64(0) << (nr % 64);
+
+        if (word) return std::min(numBlocks, (nr / 64) * 64 + std::countr_zero(word));
+        nr = (nr / 64 + 1) * 64;
+    }
+    return numBlocks;
+}
+
+BlockNr
+FSAllocator::runStart(BlockNr nr) const
+{
+    auto &map = getFreeMap();
+
+    while (true) {
+
+        // Look for an allocated block at or below 'nr' in the current word
+        u64 used = ~map[nr / 64] & (~u64(0) >> (63 - nr % 64));
+
+        if (used) return (nr / 64) * 64 + 64 - std::countl_zero(used);
+        if (nr < 64) return 0;
+        nr = (nr / 64) * 64 - 1;
+    }
+}
+
+optional<Range<BlockNr>>
+FSAllocator::findRun(isize count) const
+{
+    auto &map = getFreeMap();
+    auto numBlocks = fs.blocks();
+
+    if (count <= 0 || numBlocks == 0) return {};
+
+    BlockNr start = ap >= 0 && ap < numBlocks ? ap : 0;
+    BlockNr first, nr;
+
+    if (map[start / 64] >> (start % 64) & 1) {
+
+        // Stay close to the allocation pointer if possible
+        auto end = scan(start, false);
+        if (end - start >= count) return Range<BlockNr> { start, start + count };
+
+        // Otherwise, try the whole run containing the allocation pointer
+        first = runStart(start);
+        if (end - first >= count) return Range<BlockNr> { first, first + count };
+
+        nr = scan(end, true);
+
+    } else {
+
+        first = nr = scan(start, true);
+    }
+
+    // Visit the remaining runs in ascending order, wrapping around once
+    for (bool wrapped = false; ; ) {
+
+        if (nr >= numBlocks) {
+
+            if (wrapped) break;
+            wrapped = true;
+            nr = scan(0, true);
+        }
+        if (wrapped && nr >= first) break;
+
+        auto end = scan(nr, false);
+        if (end - nr >= count) return Range<BlockNr> { nr, nr + count };
+        nr = scan(end, true);
+    }
+
+    return {};
+}
+
+std::vector<Range<BlockNr>>
+FSAllocator::freeRuns() const
+{
+    auto numBlocks = fs.blocks();
+
+    std::vector<Range<BlockNr>> result;
+
+    for (BlockNr nr = scan(0, true); nr < numBlocks; ) {
+
+        auto end = scan(nr, false);
+        result.push_back({ nr, end });
+        nr = scan(end, true);
+    }
+
+    return result;
+}
+
 void
 FSAllocator::setAllocBit(BlockNr nr, bool value)
 {
@@ -391,7 +607,160 @@ FSAllocator::setAllocBit(BlockNr nr, bool value)
 
         auto *data = bm->mutate().data();
         REPLACE_BIT(data[byte], bit, value);
+
+        // Keep the native copy in sync
+        if (!freeMapIsStale) {
+
+            auto &word = freeMap[nr / 64];
+            auto old = std::popcount(word);
+            auto mask = u64(1) << (nr % 64);
+            if (value) word |= mask; else word &= ~mask;
+            freeCount += std::popcount(word) - old;
+        }
+    }
+}
+
+void
+FSAllocator::setAllocBits(const std::vector<BlockNr> &nrs, bool value)
+{
+    setAllocRanges(Range<BlockNr>::coalesce(nrs), value);
+}
+
+void
+FSAllocator::setAllocRanges(const std::vector<Range<BlockNr>> &ranges, bool value)
+{
+    auto &bmBlocks = fs.getBmBlocks();
+    isize bitsPerBlock = (traits.bsize - 4) * 8;
+    std::vector<bool> touched(bmBlocks.size());
+
+    // Updates the native copy for all blocks in [lower; upper)
+    auto sync = [&](BlockNr lower, BlockNr upper) {
+
+        for (auto nr = lower; nr < upper; ) {
+
+            auto end = std::min(upper, (nr / 64 + 1) * 64);
+            auto mask = (end - nr == 64 ? ~u64(0) : (u64(1) << (end - nr)) - 1) << (nr % 64);
+            auto &word = freeMap[nr / 64];
+            auto old = std::popcount(word);
+            if (value) word |= mask; else word &= ~mask;
+            freeCount += std::popcount(word) - old;
+            nr = end;
+        }
+    };
+
+    for (auto &range : ranges) {
+
+        // The first two blocks are always allocated and not part of the map
+        auto lower = std::max(range.lower, BlockNr(2));
+        auto upper = std::min(range.upper, BlockNr(fs.blocks()));
+
+        // The bitmap block that is currently processed
+        isize current = -1;
+        u8 *data = nullptr;
+
+        // Process the range in chunks of up to 32 bits
+        for (BlockNr nr = lower; nr < upper; ) {
+
+            auto bit = (nr - 2) % bitsPerBlock;
+            auto bmNr = (nr - 2) / bitsPerBlock;
+            auto count = std::min(upper - nr, 32 - bit % 32);
+
+            if (bmNr >= (isize)bmBlocks.size()) break;
+
+            // Switch to the next bitmap block if necessary
+            if (bmNr != current) {
+
+                auto *bm = fs.tryFetch(bmBlocks[bmNr], FSBlockType::BITMAP);
+                data = bm ? bm->mutate().data() : nullptr;
+                current = bmNr;
+            }
+
+            if (data) {
+
+                // Flip the bits in the big-endian long word
+                auto *p = data + 4 + (bit / 32) * 4;
+                u32 mask = u32((u64(1) << count) - 1) << (bit % 32);
+                FSBlock::write32(p, value ? FSBlock::read32(p) | mask : FSBlock::read32(p) & ~mask);
+                touched[bmNr] = true;
+
+                // Keep the native copy in sync
+                if (!freeMapIsStale) sync(nr, nr + count);
+            }
+
+            nr += count;
+        }
+    }
+
+    // Rectify the checksums of all modified bitmap blocks
+    for (usize i = 0; i < touched.size(); i++) {
+        if (touched[i]) fs.fetch(bmBlocks[i]).mutate().updateChecksum();
     }
 }
 
+const std::vector<u64> &
+FSAllocator::getFreeMap() const
+{
+    if (!freeMapIsStale) return freeMap;
+
+    auto numBlocks = fs.blocks();
+    auto &bmBlocks = fs.getBmBlocks();
+    isize bitsPerBlock = (traits.bsize - 4) * 8;
+
+    freeMap.assign((numBlocks + 63) / 64, 0);
+
+    for (isize i = 0; i < (isize)bmBlocks.size(); i++) {
+
+        auto *bm = fs.tryFetch(bmBlocks[i], FSBlockType::BITMAP);
+        if (!bm) continue;
+
+        // Transfer all long words (the first two blocks are not part of the map)
+        auto *data = bm->data();
+        for (isize j = 4; j < traits.bsize; j += 4) {
+
+            u64 word = HI_HI_LO_LO(data[j], data[j+1], data[j+2], data[j+3]);
+            BlockNr base = 2 + i * bitsPerBlock + (j - 4) * 8;
+            auto w = base / 64, shift = base % 64;
+
+            if (!word || w >= (isize)freeMap.size()) continue;
+
+            freeMap[w] |= word << shift;
+            if (shift > 32 && w + 1 < (isize)freeMap.size()) freeMap[w + 1] |= word >> (64 - shift);
+        }
+    }
+
+    // Clear the bits beyond the last block
+    if (auto bits = numBlocks % 64; bits) freeMap.back() &= (u64(1) << bits) - 1;
+
+    freeCount = 0;
+    for (auto word : freeMap) freeCount += std::popcount(word);
+
+    freeMapIsStale = false;
+    return freeMap;
+}
+
+BlockNr
+FSAllocator::findFree(BlockNr nr) const
+{
+    auto &map = getFreeMap();
+    auto numWords = (isize)map.size();
+
+    if (numWords == 0) return -1;
+    if (nr < 0 || nr >= fs.blocks()) nr = 0;
+
+    // Ignore all blocks in front of 'nr' in the first word
+    isize w = nr / 64;
+    u64 word = map[w] & (~u64(0) << (nr % 64));
+
+    // Visit all words, ending with the first word again
+    for (isize i = 0; i <= numWords; i++) {
+
+        if (word) return w * 64 + std::countr_zero(word);
+
+        w = (w + 1) % numWords;
+        word = map[w];
+    }
+
+    return -1;
+}
+
 }
@@ -20,6 +20,19 @@ public:
     // Allocation pointer (selects the block to allocate next)
     BlockNr ap = 0;
 
+private:
+
+    // Native copy of the allocation bitmap (bit n is set iff block n is free)
+    mutable std::vector<u64> freeMap;
+
+    // Number of set bits in the native copy
+    mutable isize freeCount = 0;
+
+    // Indicates whether the copy needs to be rebuilt from the bitmap blocks
+    mutable bool freeMapIsStale = true;
+
+public:
+
     using FSService::FSService;
 
 
@@ -54,14 +67,28 @@ public:
     // Allocates multiple blocks
     void allocate(isize count, std::vector<BlockNr> &result, std::vector<BlockNr> prealloc = {});
 
+    // Allocates multiple blocks in as few contiguous runs as possible
+    std::vector<Range<BlockNr>> allocateExtents(isize count);
+
+    // Allocates multiple blocks in a single contiguous run (if possible)
+    optional<Range<BlockNr>> allocateRun(isize count);
+
+    // Returns the free block closest to 'nr' (-1 if there is none)
+    [[nodiscard]] BlockNr nearestFree(BlockNr nr) const;
+
     // Deallocates a block
     void deallocateBlock(BlockNr nr);
 
-    // Allocates multiple blocks
+    // Deallocates multiple blocks
     void deallocateBlocks(const std::vector<BlockNr> &nrs);
 
-    // Allocates all blocks needed for a file
-    void allocateFileBlocks(isize bytes,
+    // Allocates all blocks needed for a file. Returns the number of extents
+    isize allocateFileBlocks(isize bytes,
+                             std::vector<BlockNr> &listBlocks, std::vector<BlockNr> &dataBlocks);
+
+    // Allocates the blocks needed to grow a file owning some list and data blocks already.
+    // Only the new blocks are appended to the lists.
+    void allocateFileBlocks(isize bytes, isize ownedListBlocks, isize ownedDataBlocks,
                             std::vector<BlockNr> &listBlocks, std::vector<BlockNr> &dataBlocks);
 
     //
@@ -83,8 +110,39 @@ public:
     void markAsFree(BlockNr nr) { setAllocBit(nr, 1); }
     void setAllocBit(BlockNr nr, bool value);
 
+    // Marks multiple blocks as allocated or free (checksums are updated)
+    void markAsAllocated(const std::vector<BlockNr> &nrs) { setAllocBits(nrs, 0); }
+    void markAsFree(const std::vector<BlockNr> &nrs) { setAllocBits(nrs, 1); }
+    void setAllocBits(const std::vector<BlockNr> &nrs, bool value);
+    void setAllocRange(Range<BlockNr> range, bool value) { setAllocRanges({ range }, value); }
+    void setAllocRanges(const std::vector<Range<BlockNr>> &ranges, bool value);
+
+    // Discards the native bitmap copy (call after bypassing setAllocBit)
+    void invalidateBitmap() noexcept { freeMapIsStale = true; }
+
 private:
 
+    // Returns the native bitmap copy (rebuilds it if necessary)
+    const std::vector<u64> &getFreeMap() const;
+
+    // Returns the first free block at or after 'nr' (wraps around, -1 if full)
+    BlockNr findFree(BlockNr nr) const;
+
+    // Returns the first block at or after 'nr' with the requested bit value
+    BlockNr scan(BlockNr nr, bool value) const;
+
+    // Returns the first block of the free run containing 'nr'
+    BlockNr runStart(BlockNr nr) const;
+
+    // Returns the first run of 'count' free blocks, starting at the allocation pointer
+    optional<Range<BlockNr>> findRun(isize count) const;
+
+    // Returns all runs of free blocks in ascending order
+    std::vector<Range<BlockNr>> freeRuns() const;
+
+    // Marks the blocks of some runs as allocated and advances the allocation pointer
+    void claim(const std::vector<Range<BlockNr>> &runs);
+
     // Locates the allocation bit for a certain block
     // FSBlock *locateAllocationBit(BlockNr nr, isize *byte, isize *bit) noexcept;
     const FSBlock *locateAllocationBit(BlockNr nr, isize *byte, isize *bit) const noexcept;
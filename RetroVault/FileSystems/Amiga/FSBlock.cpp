@@ -10,6 +10,7 @@
 #include "config.h"
 #include "FileSystems/Amiga/FSBlock.h"
 #include "FileSystems/Amiga/FileSystem.h"
+#include "FileSystems/Amiga/FSChecksum.h"
 #include "utl/io.h"
 #include "utl/support.h"
 #include <algorithm>
@@ -507,16 +508,13 @@ FSBlock::addr32(isize nr)
 u8 *
 FSBlock::data()
 {
-    if (dataCache.empty()) {
+    if (!dataCache) {
 
-        dataCache.alloc(bsize());
-        cache.dev.readBlock(dataCache.ptr, nr);
+        dataCache = cache.newSlot();
+        cache.dev.readBlock(dataCache, nr);
     }
 
-    assert(dataCache.size == bsize());
-    assert(dataCache.ptr);
-
-    return dataCache.ptr;
+    return dataCache;
 }
 
 const u8 *
@@ -541,9 +539,10 @@ FSBlock::invalidate()
 void
 FSBlock::flush()
 {
-    if (!dataCache.empty()) {
+    if (dataCache) {
         
-        cache.dev.writeBlock(dataCache.ptr, nr);
+        cache.updateChecksum(nr);
+        cache.dev.writeBlock(dataCache, nr);
     }
 }
 
@@ -601,28 +600,10 @@ FSBlock::checksumStandard() const
     isize pos = checksumLocation();
     assert(pos >= 0 && pos <= 5);
 
-    // Wipe out the old checksum
-    u32 old = get32(pos);
-    const_cast<FSBlock *>(this)->set32(pos, 0); // TODO: DON'T DO THIS
-
-    // Compute the new checksum
-    u32 result = 0;
-    for (isize i = 0; i < bsize() / 4; i++)  U32_INC(result, get32(i));
-    result = ~result;
-    U32_INC(result, 1);
-
-    // Undo the modification
-    const_cast<FSBlock *>(this)->set32(pos, old); // TODO: DON'T DO THIS
-
-    // Compute the new checksum
-    u32 result2 = 0;
-    for (isize i = 0; i < bsize() / 4; i++)  if (i != pos) U32_INC(result2, get32(i));
-    result2 = ~result2;
-    U32_INC(result2, 1);
-
-    assert(result == result2);
+    // Add up all long words except the checksum itself
+    u32 result = FSChecksum::sum32(data(), bsize() / 4) - get32(pos);
 
-    return result;
+    return ~result + 1;
 }
 
 u32
@@ -631,29 +612,24 @@ FSBlock::checksumBootBlock() const
     // Only call this function for the first boot block in a partition
     assert(nr == 0);
 
-    u32 result = get32(0), prec;
-
-    // First boot block
-    for (isize i = 2; i < bsize() / 4; i++) {
-
-        prec = result;
-        if ( (result += get32(i)) < prec) result++;
-    }
-
-    // Second boot block
-    auto *p = fs->cache[1].data();
-
-    for (isize i = 0; i < bsize() / 4; i++) {
+    // Add up all long words of both boot blocks except the checksum itself
+    u64 result = FSChecksum::sum64(data(), bsize() / 4) - get32(1);
+    result += FSChecksum::sum64(fs->cache[1].data(), bsize() / 4);
 
-        prec = result;
-        if ( (result += FSBlock::read32(p + 4*i)) < prec) result++;
-    }
+    // Fold the carries back in (end-around carry)
+    while (result >> 32) result = (result & 0xFFFFFFFF) + (result >> 32);
 
-    return ~result;
+    return ~u32(result);
 }
 
 void
 FSBlock::updateChecksum()
+{
+    cache.markChecksumAsStale(nr);
+}
+
+void
+FSBlock::writeChecksum()
 {
     isize pos = checksumLocation();
     if (pos >= 0 && pos < bsize() / 4) set32(pos, checksum());
@@ -1929,9 +1905,9 @@ FSBlock::extractData(Buffer<u8> &buf) const
 
     buf.init(bytesRemaining);
 
-    for (auto &it : fs->collectDataBlocks(*this)) {
+    for (auto &it : fs->collectDataBlocks(nr)) {
 
-        isize bytesWritten = it->writeData(buf, bytesTotal, bytesRemaining);
+        isize bytesWritten = fs->fetch(it).writeData(buf, bytesTotal, bytesRemaining);
         bytesTotal += bytesWritten;
         bytesRemaining -= bytesWritten;
     }
@@ -2008,6 +1984,33 @@ FSBlock::writeData(Buffer<u8> &buf, isize offset, isize count) const
     }
 }
 
+isize
+FSBlock::readData(u8 *dst, isize pos, isize count) const
+{
+    // Skip the header of OFS data blocks
+    auto offset = type == FSBlockType::DATA_OFS ? 24 : 0;
+    auto capacity = bsize() - (fs->getTraits().ofs() ? 24 : 0);
+
+    count = std::clamp(capacity - pos, isize(0), count);
+
+    switch (type) {
+
+        case FSBlockType::DATA_OFS:
+        case FSBlockType::DATA_FFS:
+
+            std::memcpy(dst, data() + offset + pos, count);
+            return count;
+
+        case FSBlockType::EMPTY:
+
+            std::memset(dst, 0, count);
+            return count;
+
+        default:
+            throw FSError(FSError::FS_CORRUPTED, "Block " + std::to_string(nr) + " is no data block");
+    }
+}
+
 isize
 FSBlock::overwriteData(Buffer<u8> &buf)
 {
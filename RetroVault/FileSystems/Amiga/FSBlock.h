@@ -36,8 +36,8 @@ struct FSBlock : Loggable, Hashable, Dumpable {
     // The sector number of this block
     BlockNr nr = 0;
 
-    // Cached block data
-    Buffer<u8> dataCache;
+    // Cached block data (a bsize() slot in one of the block cache arenas)
+    u8 *dataCache = nullptr;
 
 
     //
@@ -67,7 +67,7 @@ public:
 
     u64 hash(HashAlgorithm algorithm) const override {
 
-        return dataCache.empty() ? 0 : dataCache.hash(algorithm);
+        return dataCache ? Hashable::hash(dataCache, bsize(), algorithm) : 0;
     }
 
 
@@ -77,10 +77,10 @@ public:
 
     Dumpable::DataProvider dataProvider() const override {
 
-        if (dataCache.empty()) {
+        if (!dataCache) {
             return [&](isize offset, isize bytes) { return offset < bsize() ? 0 : -1; };
         } else {
-            return dataCache.dataProvider();
+            return Dumpable::dataProvider(dataCache, bsize());
         }
     }
 
@@ -181,8 +181,11 @@ public:
     // Computes a checksum for this block
     u32 checksum() const;
     
-    // Updates the checksum in this block
+    // Updates the checksum in this block (postponed until it is needed)
     void updateChecksum();
+
+    // Updates the checksum in this block right away
+    void writeChecksum();
     
 private:
 
@@ -405,6 +408,9 @@ public:
     isize writeData(Buffer<u8> &buf, isize offset, isize count) const;
     isize extractData(Buffer<u8> &buf) const;
 
+    // Copies data bytes into a buffer, starting at a position inside the data area
+    isize readData(u8 *dst, isize pos, isize count) const;
+
     
     //
     // Importing
@@ -15,9 +15,11 @@
 
 namespace retro::vault::amiga {
 
-FSCache::FSCache(FileSystem &fs, Volume &v) : FSService(fs), dev(v) {
+FSCache::FSCache(FileSystem &fs, Volume &v) : FSService(fs), dev(v),
+table((v.capacity() + pageSize - 1) / pageSize) {
 
-    blocks.reserve(v.capacity());
+    types.assign(v.capacity(), u8(FSBlockType::EMPTY));
+    state.assign(v.capacity(), 0);
 };
 
 FSCache::~FSCache()
@@ -28,7 +30,14 @@ FSCache::~FSCache()
 void
 FSCache::dealloc()
 {
-    blocks.clear();
+    for (auto &page : table) page = nullptr;
+    pages.clear();
+    objects.clear();
+    spareObjects.clear();
+    arenas.clear();
+    spareSlots.clear();
+    numCached = 0;
+    hand = 0;
 }
 
 void
@@ -37,7 +46,14 @@ FSCache::dump(std::ostream &os) const
     using namespace utl;
 
     os << tab("Capacity") << capacity() << " blocks (x " << bsize() << " bytes)" << std::endl;
-    os << tab("Hashed blocks") << blocks.size() << std::endl;
+    os << tab("Cached blocks") << numCached << std::endl;
+    os << tab("Dirty blocks") << numDirty << std::endl;
+    os << tab("Arenas") << arenas.size() << " (x " << slotsPerArena << " slots)" << std::endl;
+    os << tab("Pinned blocks") << pins.size() << std::endl;
+    os << tab("Budget") << (budget ? byteCountAsString(budget) : "Unlimited") << std::endl;
+    os << tab("Hits") << cacheHits() << std::endl;
+    os << tab("Misses") << misses << std::endl;
+    os << tab("Evictions") << evictions << std::endl;
 }
 
 FSFormat
@@ -58,10 +74,9 @@ std::vector<BlockNr>
 FSCache::sortedKeys() const
 {
     std::vector<BlockNr> result;
-    result.reserve(blocks.size());
+    result.reserve(numCached);
 
-    for (const auto& [key, _] : blocks) result.push_back(key);
-    std::ranges::sort(result);
+    for (auto key : keys()) result.push_back(key);
 
     return result;
 }
@@ -75,8 +90,11 @@ FSCache::isEmpty(BlockNr nr) const noexcept
 FSBlockType
 FSCache::getType(BlockNr nr) const noexcept
 {
-    if (isize(nr) >= capacity()) return FSBlockType::UNKNOWN;
-    return blocks.contains(nr) ? blocks.at(nr)->type : FSBlockType::EMPTY;
+    if (nr < 0 || isize(nr) >= capacity()) return FSBlockType::UNKNOWN;
+
+    // Evicted blocks are reported with the type they had when leaving the cache
+    auto *block = lookup(nr);
+    return block ? block->type : FSBlockType(types[nr]);
 }
 
 /*
@@ -91,26 +109,106 @@ FSCache::setType(BlockNr nr, FSBlockType type)
 FSBlock *
 FSCache::cache(BlockNr nr) const noexcept
 {
-    if (isize(nr) >= capacity()) return nullptr;
+    if (nr < 0 || isize(nr) >= capacity()) return nullptr;
+
+    auto &hitCount = hits[nr % numLatches].value;
+
+    // Give the block a second chance in the replacement algorithm (skip the
+    // write if the flag is set already to keep hot blocks' cache lines shared)
+    if (std::atomic_ref<u8> flags(state[nr]); !(flags.load(std::memory_order_relaxed) & REFERENCED)) {
+        flags.fetch_or(REFERENCED, std::memory_order_relaxed);
+    }
 
     // Look up the block in the cache and return it if already present
-    // On a miss, reserve an entry with a placeholder value
-    auto [it, inserted] = blocks.try_emplace(nr, nullptr);
-    if (!inserted) return it->second.get();
+    if (auto *block = lookup(nr)) { hitCount.fetch_add(1, std::memory_order_relaxed); return block; }
+
+    // Serialize with other threads that are about to fill the same entry
+    std::lock_guard<std::mutex> guard(latch(nr));
+    if (auto *block = lookup(nr)) { hitCount.fetch_add(1, std::memory_order_relaxed); return block; }
+    misses++;
+
+    auto &entry = this->entry(nr);
 
     // Create the block cache entry
-    auto block = std::make_unique<FSBlock>(&fs, nr);
-    block->dataCache.alloc(bsize());
+    FSBlock *block;
+    {   std::lock_guard<std::mutex> pool(poolLock);
 
-    // Read block data from the underlying block device
-    dev.readBlock(block->dataCache.ptr, nr);
+        block = newBlock(nr);
+        block->dataCache = newSlot();
+    }
+
+    // Read block data from the underlying block device (unless wiped)
+    if (std::atomic_ref<u8>(state[nr]).load(std::memory_order_relaxed) & WIPED) {
+        memset(block->dataCache, 0, bsize());
+    } else {
+        dev.readBlock(block->dataCache, nr);
+    }
 
     // Predict the block type based on its number and cached data
-    block->type = fs.predictType(nr, block->dataCache.ptr);
+    block->type = fs.predictType(nr, block->dataCache);
+
+    // Publish the table entry
+    entry.store(block, std::memory_order_release);
+    numCached++;
+
+    return block;
+}
+
+FSCache::Entry &
+FSCache::entry(BlockNr nr) const
+{
+    auto &ref = table[nr / pageSize];
+    auto *page = ref.load(std::memory_order_acquire);
+
+    if (!page) {
+
+        std::lock_guard<std::mutex> pool(poolLock);
+
+        // Allocate the page unless another thread has done it in the meantime
+        page = ref.load(std::memory_order_acquire);
+        if (!page) {
+
+            page = pages.emplace_back(std::make_unique<Entry[]>(pageSize)).get();
+            ref.store(page, std::memory_order_release);
+        }
+    }
+
+    return page[nr % pageSize];
+}
+
+FSBlock *
+FSCache::newBlock(BlockNr nr) const
+{
+    if (spareObjects.empty()) return &objects.emplace_back(&fs, nr);
+
+    // Recycle a block object that has been released before
+    auto *block = spareObjects.back();
+    spareObjects.pop_back();
+
+    block->nr = nr;
+    block->type = FSBlockType::UNKNOWN;
+    block->dataCache = nullptr;
+
+    return block;
+}
+
+u8 *
+FSCache::newSlot() const
+{
+    if (spareSlots.empty()) {
+
+        // Carve a new arena into slots
+        auto bs = bsize();
+        auto &arena = arenas.emplace_back(std::make_unique_for_overwrite<u8[]>(slotsPerArena * bs));
 
-    // Populate the reserved cache entry
-    it->second = std::move(block);
-    return it->second.get();
+        spareSlots.reserve(spareSlots.size() + slotsPerArena);
+        for (isize i = slotsPerArena - 1; i >= 0; i--) spareSlots.push_back(arena.get() + i * bs);
+    }
+
+    auto *slot = spareSlots.back();
+    spareSlots.pop_back();
+
+    return slot;
 }
 
 const FSBlock *
@@ -236,26 +334,132 @@ FSCache::modify(BlockNr nr, std::vector<FSBlockType> types)
 void
 FSCache::erase(BlockNr nr)
 {
-    if (blocks.contains(nr)) { blocks.erase(nr); }
+    if (nr < 0 || isize(nr) >= capacity()) return;
+
+    // The block is discarded, so there is nothing to write back
+    if (state[nr] & DIRTY) { state[nr] &= ~DIRTY; numDirty--; }
+    state[nr] &= ~STALE_CHECKSUM;
+
+    if (lookup(nr)) { drop(nr); }
+    types[nr] = u8(FSBlockType::EMPTY);
+}
+
+void
+FSCache::wipe(Range<BlockNr> range)
+{
+    auto lower = std::max(range.lower, BlockNr(0));
+    auto upper = std::min(range.upper, BlockNr(capacity()));
+    if (lower >= upper) return;
+
+    // Drop all cached blocks, skipping unpopulated pages of the block table
+    for (BlockNr nr = lower; nr < upper; ) {
+
+        auto end = std::min(upper, (nr / pageSize + 1) * pageSize);
+        if (table[nr / pageSize].load()) {
+            for (; nr < end; nr++) if (lookup(nr)) drop(nr);
+        }
+        nr = end;
+    }
+
+    // The blocks are discarded, so there is nothing to write back
+    numDirty -= std::count_if(state.begin() + lower, state.begin() + upper,
+                              [](u8 s) { return s & DIRTY; });
+
+    std::fill(state.begin() + lower, state.begin() + upper, WIPED);
+    std::fill(types.begin() + lower, types.begin() + upper, u8(FSBlockType::EMPTY));
+    wipeList.push_back({ lower, upper });
+
+    fs.stepGeneration();
+}
+
+void
+FSCache::drop(BlockNr nr) const noexcept
+{
+    auto &entry = this->entry(nr);
+    auto *block = entry.load();
+    assert(block);
+
+    // Remember the block type
+    types[nr] = u8(block->type);
+    state[nr] &= ~REFERENCED;
+
+    // Return the payload slot and the block object to the free lists
+    spareSlots.push_back(block->dataCache);
+    block->dataCache = nullptr;
+    spareObjects.push_back(block);
+
+    entry = nullptr;
+    numCached--;
 }
 
 void
 FSCache::markAsDirty(BlockNr nr)
 {
-    dirty.insert(nr);
+    if (nr < 0 || isize(nr) >= capacity()) return;
+
+    if (!(state[nr] & DIRTY)) {
+
+        state[nr] |= DIRTY;
+        dirtyList.push_back(nr);
+        numDirty++;
+    }
     fs.stepGeneration();
 }
 
+void
+FSCache::markChecksumAsStale(BlockNr nr)
+{
+    if (nr < 0 || isize(nr) >= capacity()) return;
+
+    markAsDirty(nr);
+    state[nr] |= STALE_CHECKSUM;
+}
+
+void
+FSCache::updateChecksum(BlockNr nr)
+{
+    if (nr < 0 || isize(nr) >= capacity()) return;
+
+    if (state[nr] & STALE_CHECKSUM) {
+
+        state[nr] &= ~STALE_CHECKSUM;
+        if (auto *block = lookup(nr)) block->writeChecksum();
+    }
+}
+
+void
+FSCache::updateChecksums()
+{
+    // Blocks with a postponed checksum are always dirty
+    for (usize i = 0; i < dirtyList.size(); i++) updateChecksum(dirtyList[i]);
+}
+
 void
 FSCache::flush()
 {
-    loginfo(FS_DEBUG, "Flushing %zd dirty blocks\n", dirty.size());
+    loginfo(FS_DEBUG, "Flushing %zd dirty blocks\n", numDirty);
+
+    // Compute all postponed checksums
+    updateChecksums();
     
     std::vector<u8> buffer;
     auto bs = bsize();
 
+    // Zero all wiped blocks on the device first
+    for (auto &range : wipeList) {
+
+        dev.eraseBlocks(range);
+        for (auto nr = range.lower; nr < range.upper; nr++) state[nr] &= ~WIPED;
+    }
+    wipeList.clear();
+
+    // Drop duplicates and all blocks that have been erased in the meantime
+    std::ranges::sort(dirtyList);
+    dirtyList.erase(std::unique(dirtyList.begin(), dirtyList.end()), dirtyList.end());
+    std::erase_if(dirtyList, [&](BlockNr nr) { return !(state[nr] & DIRTY); });
+
     // Arrage dirty blocks in segments
-    auto segments = Range<BlockNr>::coalesce(dirty);
+    auto segments = Range<BlockNr>::coalesce(dirtyList);
     
     for (auto seg: segments) {
 
@@ -265,12 +469,12 @@ FSCache::flush()
         // Gather block data
         for (isize i = seg.lower; i < seg.upper; ++i) {
             
-            auto it = blocks.find(i);
+            auto *block = lookup(i);
             
-            if (it == blocks.end())
+            if (!block)
                 throw FSError(FSError::FS_CORRUPTED, "Cache mismatch: " + std::to_string(i));
             
-            memcpy(buffer.data() + (i - seg.lower) * bs, it->second->data(), bs);
+            memcpy(buffer.data() + (i - seg.lower) * bs, block->dataCache, bs);
         }
         
         // Write the buffer back to the device
@@ -279,14 +483,87 @@ FSCache::flush()
     }
     
     // Mark all blocks as up-to-date
-    dirty.clear();
+    for (auto nr : dirtyList) state[nr] &= ~DIRTY;
+    dirtyList.clear();
+    numDirty = 0;
 }
 
 void
 FSCache::invalidate()
 {
-    blocks.clear();
-    dirty.clear();
+    dealloc();
+
+    std::ranges::fill(types, u8(FSBlockType::EMPTY));
+    std::ranges::fill(state, 0);
+    dirtyList.clear();
+    wipeList.clear();
+    numDirty = 0;
+}
+
+isize
+FSCache::cacheHits() const noexcept
+{
+    isize result = 0;
+    for (auto &counter : hits) result += counter.value.load(std::memory_order_relaxed);
+    return result;
+}
+
+void
+FSCache::unpin(BlockNr nr) noexcept
+{
+    if (auto it = pins.find(nr); it != pins.end()) {
+
+        if (--it->second <= 0) pins.erase(it);
+    }
+}
+
+bool
+FSCache::exceedsBudget() const noexcept
+{
+    if (budget == 0) return false;
+
+    // Dirty blocks are never evicted, so they do not count as an excess
+    return numCached > std::max({ isize(1), budget / bsize(), numDirty });
+}
+
+void
+FSCache::trim() const noexcept
+{
+    if (budget == 0) return;
+
+    // Determine the number of blocks that fit into the budget
+    auto limit = std::max(isize(1), budget / bsize());
+
+    // Dirty blocks are never evicted, so there is no point in sweeping past them
+    limit = std::max(limit, isize(numDirty));
+
+    // Every block is visited at most twice (clearing its reference bit first)
+    auto steps = 2 * capacity();
+
+    while (numCached > limit && steps-- > 0) {
+
+        if (hand >= capacity()) hand = 0;
+
+        // Skip unpopulated pages of the block table
+        if (!table[hand / pageSize].load()) { hand = (hand / pageSize + 1) * pageSize; continue; }
+
+        auto nr = hand++;
+        if (!lookup(nr)) continue;
+
+        // Dirty and pinned blocks are never evicted
+        if ((state[nr] & DIRTY) || pins.contains(nr)) continue;
+
+        // Give recently used blocks a second chance
+        if (state[nr] & REFERENCED) { state[nr] &= ~REFERENCED; continue; }
+
+        // Evict the block
+        drop(nr);
+        evictions++;
+    }
+
+    if (numCached > limit) {
+        loginfo(FS_DEBUG, "Cache exceeds budget (%zd blocks are dirty or pinned)\n", numCached.load());
+    }
 }
 
 }
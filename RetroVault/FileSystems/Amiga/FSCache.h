@@ -14,9 +14,13 @@
 #include "FileSystems/Amiga/FSBlock.h"
 #include "FileSystems/Amiga/FSService.h"
 #include "Volume.h"
+#include <array>
+#include <atomic>
+#include <deque>
 #include <iostream>
+#include <mutex>
 #include <ranges>
-#include <unordered_set>
+#include <unordered_map>
 
 namespace retro::vault::amiga {
 
@@ -24,16 +28,79 @@ class FSCache final : public FSService {
     
     friend struct FSBlock;
     
+    // Number of entries in a single page of the block table
+    static constexpr isize pageSize = 4096;
+
+    // Number of payload slots in a single arena
+    static constexpr isize slotsPerArena = 256;
+
+    // Number of latches serializing concurrent cache fills
+    static constexpr isize numLatches = 64;
+
+    // Block state flags
+    static constexpr u8 DIRTY = 0x01;
+    static constexpr u8 REFERENCED = 0x02;
+    static constexpr u8 WIPED = 0x04;
+    static constexpr u8 STALE_CHECKSUM = 0x08;
+
 private:
     
     // The underlying volume
     Volume &dev;
     
-    // Cached blocks
-    mutable std::unordered_map<BlockNr, std::unique_ptr<FSBlock>> blocks;
+    // Entry of the block table (nullptr if the block is not cached)
+    using Entry = std::atomic<FSBlock *>;
+
+    // Block table, indexed by block number and split into lazily allocated pages
+    mutable std::vector<std::atomic<Entry *>> table;
+
+    // Storage of all allocated pages
+    mutable std::vector<std::unique_ptr<Entry[]>> pages;
+
+    // Latches serializing threads that fill the same block table entry
+    mutable std::array<std::mutex, numLatches> latches;
+
+    // Protects the page storage, the block objects, and the payload slots
+    mutable std::mutex poolLock;
+
+    // Block objects and the ones that are ready for reuse
+    mutable std::deque<FSBlock> objects;
+    mutable std::vector<FSBlock *> spareObjects;
+
+    // Payload arenas carved into bsize() slots and the unused slots
+    mutable std::vector<std::unique_ptr<u8[]>> arenas;
+    mutable std::vector<u8 *> spareSlots;
+
+    // Last known type and state flags of each block (parallel to the table)
+    mutable std::vector<u8> types;
+    mutable std::vector<u8> state;
+
+    // Blocks that have been marked dirty since the last flush
+    std::vector<BlockNr> dirtyList;
+
+    // Block ranges that need to be zeroed on the device with the next flush
+    std::vector<Range<BlockNr>> wipeList;
+
+    // Number of cached blocks and dirty blocks
+    mutable std::atomic<isize> numCached = 0;
+    isize numDirty = 0;
     
-    // Dirty blocks
-    mutable std::unordered_set<BlockNr> dirty;
+    // Pinned blocks with their pin counts
+    std::unordered_map<BlockNr, isize> pins;
+
+    // Clock hand of the replacement algorithm (CLOCK)
+    mutable BlockNr hand = 0;
+
+    // Memory budget in bytes (0 = unlimited)
+    isize budget = 0;
+
+    // Counter occupying a cache line of its own (prevents false sharing)
+    struct alignas(64) Counter { std::atomic<isize> value = 0; };
+
+    // Access statistics (hits are spread across the latches to avoid contention)
+    mutable std::array<Counter, numLatches> hits;
+    mutable std::atomic<isize> misses = 0;
+    mutable std::atomic<isize> evictions = 0;
     
     
     //
@@ -72,7 +139,7 @@ public:
     
     // Reports usage information
     isize freeBlocks() const { return capacity() - usedBlocks(); }
-    isize usedBlocks() const { return (isize)blocks.size(); }
+    isize usedBlocks() const { return numCached; }
     isize freeBytes() const { return freeBlocks() * bsize(); }
     isize usedBytes() const { return usedBlocks() * bsize(); }
     double fillLevel() const { return capacity() ? double(100) * usedBlocks() / capacity() : 0; }
@@ -87,15 +154,16 @@ public:
     // Accessing blocks
     //
     
-    // Returns a view for all keys
-    auto keys() const { return std::views::keys(blocks); }
-    
     // Returns a view for all keys in a particular range
     auto keys(BlockNr min, BlockNr max) const {
         
-        auto in_range = [=](BlockNr key) { return key >= min && key <= max; };
-        return std::views::keys(blocks) | std::views::filter(in_range);
+        auto cached = [this](BlockNr key) { return lookup(key) != nullptr; };
+        return std::views::iota(std::max(min, BlockNr(0)), std::min(max + 1, capacity()))
+        | std::views::filter(cached);
     }
+
+    // Returns a view for all keys
+    auto keys() const { return keys(0, capacity() - 1); }
     
     // Returns a vector with all keys in sorted order
     std::vector<BlockNr> sortedKeys() const;
@@ -107,8 +175,29 @@ public:
     FSBlockType getType(BlockNr nr) const noexcept;
     // void setType(BlockNr nr, FSBlockType type);
     
-    // Caches a block (if not already cached)
+    // Caches a block (if not already cached). Safe to call concurrently.
     FSBlock *cache(BlockNr nr) const noexcept;
+
+private:
+
+    // Looks up a block in the block table (returns nullptr if not cached)
+    FSBlock *lookup(BlockNr nr) const noexcept {
+
+        auto *page = table[nr / pageSize].load(std::memory_order_acquire);
+        return page ? page[nr % pageSize].load(std::memory_order_acquire) : nullptr;
+    }
+
+    // Returns the block table entry of a block (allocates the page if needed)
+    Entry &entry(BlockNr nr) const;
+
+    // Returns the latch guarding the block table entry of a block
+    std::mutex &latch(BlockNr nr) const noexcept { return latches[nr % numLatches]; }
+
+    // Hands out a block object or a payload slot
+    FSBlock *newBlock(BlockNr nr) const;
+    u8 *newSlot() const;
+
+public:
     
     // Returns a pointer to a block with read permissions (maybe null)
     const FSBlock *tryFetch(BlockNr nr) const noexcept;
@@ -135,18 +224,66 @@ public:
     
     // Wipes out a block (makes it an empty block)
     void erase(BlockNr nr);
+
+    // Wipes out a range of blocks without caching them. The blocks read as
+    // zeroes from now on. The device is zeroed with the next flush.
+    void wipe(Range<BlockNr> range);
     
-    
+private:
+
+    // Removes a block from the cache without writing it back
+    void drop(BlockNr nr) const noexcept;
+
+
     //
     // Caching
     //
     
-    isize cachedBlocks() const { return (isize)blocks.size(); }
-    isize dirtyBlocks() const { return (isize)dirty.size(); }
+public:
+
+    isize cachedBlocks() const { return numCached; }
+    isize dirtyBlocks() const { return numDirty; }
     void markAsDirty(BlockNr nr);
-    
+
+    // Postpones the checksum computation of a modified block
+    void markChecksumAsStale(BlockNr nr);
+
+    // Computes postponed checksums (of a single block or all blocks)
+    void updateChecksum(BlockNr nr);
+    void updateChecksums();
+
     void flush();
     void invalidate();
+
+
+    //
+    // Managing the memory budget
+    //
+
+public:
+
+    // Gets or sets the memory budget in bytes (0 = unlimited)
+    isize getBudget() const noexcept { return budget; }
+    void setBudget(isize bytes) noexcept { budget = std::max(isize(0), bytes); }
+
+    // Protects a block from being evicted
+    void pin(BlockNr nr) noexcept { pins[nr]++; }
+    void unpin(BlockNr nr) noexcept;
+    bool isPinned(BlockNr nr) const noexcept { return pins.contains(nr); }
+
+    // Checks whether the cache holds more blocks than the budget permits
+    bool exceedsBudget() const noexcept;
+
+    // Evicts clean, unpinned blocks until the cache fits into the budget.
+    // Blocks are never evicted elsewhere. Hence, references obtained via
+    // fetch() or modify() remain valid until the next call to this function.
+    // Unlike cache(), this function must not run concurrently with readers.
+    void trim() const noexcept;
+
+    // Returns access statistics
+    isize cacheHits() const noexcept;
+    isize cacheMisses() const noexcept { return misses; }
+    isize cacheEvictions() const noexcept { return evictions; }
 };
 
 }
@@ -0,0 +1,218 @@
+// -----------------------------------------------------------------------------
+// This file is part of RetroVault
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the Mozilla Public License v2
+//
+// See https://mozilla.org/MPL/2.0 for license information
+// -----------------------------------------------------------------------------
+
+#include "config.h"
+#include "FileSystems/Amiga/FSChecksum.h"
+
+#if defined(FS_CHECKSUM_SSE2) || defined(FS_CHECKSUM_AVX2)
+#include <immintrin.h>
+#elif defined(FS_CHECKSUM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace retro::vault::amiga {
+
+static inline u32
+read32(const u8 *p)
+{
+    return u32(p[0]) << 24 | u32(p[1]) << 16 | u32(p[2]) << 8 | u32(p[3]);
+}
+
+u32
+FSChecksum::sum32(const u8 *p, isize count)
+{
+#if defined(FS_CHECKSUM_AVX2)
+    return sum32AVX2(p, count);
+#elif defined(FS_CHECKSUM_SSE2)
+    return sum32SSE2(p, count);
+#elif defined(FS_CHECKSUM_NEON)
+    return sum32NEON(p, count);
+#else
+    return sum32Scalar(p, count);
+#endif
+}
+
+u64
+FSChecksum::sum64(const u8 *p, isize count)
+{
+#if defined(FS_CHECKSUM_AVX2)
+    return sum64AVX2(p, count);
+#elif defined(FS_CHECKSUM_SSE2)
+    return sum64SSE2(p, count);
+#elif defined(FS_CHECKSUM_NEON)
+    return sum64NEON(p, count);
+#else
+    return sum64Scalar(p, count);
+#endif
+}
+
+u32
+FSChecksum::sum32Scalar(const u8 *p, isize count)
+{
+    u32 result = 0;
+    for (isize i = 0; i < count; i++) result += read32(p + 4 * i);
+    return result;
+}
+
+u64
+FSChecksum::sum64Scalar(const u8 *p, isize count)
+{
+    u64 result = 0;
+    for (isize i = 0; i < count; i++) result += read32(p + 4 * i);
+    return result;
+}
+
+#ifdef FS_CHECKSUM_SSE2
+
+u32
+FSChecksum::sum32SSE2(const u8 *p, isize count)
+{
+    u32 result = 0;
+    isize i = 0;
+
+    auto acc = _mm_setzero_si128();
+
+    for (; i + 4 <= count; i += 4) {
+
+        auto v = _mm_loadu_si128((const __m128i *)(p + 4 * i));
+
+        // Swap the 16-bit halves, then the bytes inside each half
+        v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        acc = _mm_add_epi32(acc, v);
+    }
+
+    alignas(16) u32 lanes[4];
+    _mm_store_si128((__m128i *)lanes, acc);
+    for (auto lane : lanes) result += lane;
+
+    // Process the remaining long words
+    return result + sum32Scalar(p + 4 * i, count - i);
+}
+
+u64
+FSChecksum::sum64SSE2(const u8 *p, isize count)
+{
+    u64 result = 0;
+    isize i = 0;
+
+    const auto zero = _mm_setzero_si128();
+    auto acc = _mm_setzero_si128();
+
+    for (; i + 4 <= count; i += 4) {
+
+        auto v = _mm_loadu_si128((const __m128i *)(p + 4 * i));
+
+        // Swap the 16-bit halves, then the bytes inside each half
+        v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+
+        // Widen to 64 bit
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+    }
+
+    alignas(16) u64 lanes[2];
+    _mm_store_si128((__m128i *)lanes, acc);
+    for (auto lane : lanes) result += lane;
+
+    // Process the remaining long words
+    return result + sum64Scalar(p + 4 * i, count - i);
+}
+
+#endif
+
+#ifdef FS_CHECKSUM_AVX2
+
+u32
+FSChecksum::sum32AVX2(const u8 *p, isize count)
+{
+    u32 result = 0;
+    isize i = 0;
+
+    const auto swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                       3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    auto acc = _mm256_setzero_si256();
+
+    for (; i + 8 <= count; i += 8) {
+
+        auto v = _mm256_loadu_si256((const __m256i *)(p + 4 * i));
+        acc = _mm256_add_epi32(acc, _mm256_shuffle_epi8(v, swap));
+    }
+
+    alignas(32) u32 lanes[8];
+    _mm256_store_si256((__m256i *)lanes, acc);
+    for (auto lane : lanes) result += lane;
+
+    // Process the remaining long words
+    return result + sum32Scalar(p + 4 * i, count - i);
+}
+
+u64
+FSChecksum::sum64AVX2(const u8 *p, isize count)
+{
+    u64 result = 0;
+    isize i = 0;
+
+    const auto swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                       3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    auto acc = _mm256_setzero_si256();
+
+    for (; i + 8 <= count; i += 8) {
+
+        auto v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(p + 4 * i)), swap);
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+
+    alignas(32) u64 lanes[4];
+    _mm256_store_si256((__m256i *)lanes, acc);
+    for (auto lane : lanes) result += lane;
+
+    // Process the remaining long words
+    return result + sum64Scalar(p + 4 * i, count - i);
+}
+
+#endif
+
+#ifdef FS_CHECKSUM_NEON
+
+u32
+FSChecksum::sum32NEON(const u8 *p, isize count)
+{
+    isize i = 0;
+
+    auto acc = vdupq_n_u32(0);
+
+    for (; i + 4 <= count; i += 4) {
+        acc = vaddq_u32(acc, vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p + 4 * i))));
+    }
+
+    // Process the remaining long words
+    return vaddvq_u32(acc) + sum32Scalar(p + 4 * i, count - i);
+}
+
+u64
+FSChecksum::sum64NEON(const u8 *p, isize count)
+{
+    isize i = 0;
+
+    auto acc = vdupq_n_u64(0);
+
+    for (; i + 4 <= count; i += 4) {
+        acc = vpadalq_u32(acc, vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p + 4 * i))));
+    }
+
+    // Process the remaining long words
+    return vaddvq_u64(acc) + sum64Scalar(p + 4 * i, count - i);
+}
+
+#endif
+
+}
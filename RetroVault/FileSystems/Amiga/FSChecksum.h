@@ -0,0 +1,59 @@
+// -----------------------------------------------------------------------------
+// This file is part of RetroVault
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the Mozilla Public License v2
+//
+// See https://mozilla.org/MPL/2.0 for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "utl/types/Integers.h"
+
+// Vector extensions the checksum kernels are compiled for
+#if defined(__AVX2__)
+#define FS_CHECKSUM_AVX2
+#endif
+#if defined(__SSE2__)
+#define FS_CHECKSUM_SSE2
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define FS_CHECKSUM_NEON
+#endif
+
+namespace retro::vault::amiga {
+
+using namespace utl;
+
+/* Block checksums are computed by adding up big-endian long words, either
+ * modulo 2^32 (standard blocks) or in 64-bit precision (boot blocks).
+ * sum32() and sum64() select the widest kernel available at compile time.
+ * The individual kernels are exposed to compare them against the scalar
+ * implementation.
+ */
+struct FSChecksum {
+
+    // Adds up big-endian long words (modulo 2^32 or in 64-bit precision)
+    static u32 sum32(const u8 *p, isize count);
+    static u64 sum64(const u8 *p, isize count);
+
+    // Kernels
+    static u32 sum32Scalar(const u8 *p, isize count);
+    static u64 sum64Scalar(const u8 *p, isize count);
+
+#ifdef FS_CHECKSUM_SSE2
+    static u32 sum32SSE2(const u8 *p, isize count);
+    static u64 sum64SSE2(const u8 *p, isize count);
+#endif
+#ifdef FS_CHECKSUM_AVX2
+    static u32 sum32AVX2(const u8 *p, isize count);
+    static u64 sum64AVX2(const u8 *p, isize count);
+#endif
+#ifdef FS_CHECKSUM_NEON
+    static u32 sum32NEON(const u8 *p, isize count);
+    static u64 sum64NEON(const u8 *p, isize count);
+#endif
+};
+
+}
@@ -98,6 +98,8 @@ FSDoctor::dump(BlockNr nr, std::ostream &os)
 {
     using namespace utl;
 
+    fs.updateChecksum(nr);
+
     auto &p = fs.fetch(nr);
     auto *bdata = p.data();
 
@@ -285,6 +287,9 @@ FSDoctor::xray(bool strict, std::ostream &os, bool verbose)
 
             diagnosis.blockErrors.push_back(BlockNr(nr));
         }
+
+        // Keep the block cache within its memory budget
+        fs.trim();
     }
 
     return isize(diagnosis.blockErrors.size());
@@ -311,6 +316,9 @@ FSDoctor::xrayBitmap(bool strict)
             used.insert(listBlocks.begin(), listBlocks.end());
             used.insert(dataBlocks.begin(), dataBlocks.end());
         }
+
+        // Keep the block cache within its memory budget
+        fs.trim();
     }
     used.insert(fs.getBmBlocks().begin(), fs.getBmBlocks().end());
     used.insert(fs.getBmExtBlocks().begin(), fs.getBmExtBlocks().end());
@@ -400,6 +408,9 @@ FSDoctor::xray32(BlockNr ref, isize pos, bool strict, optional<u32> &expected) c
 {
     assert(pos % 4 == 0);
 
+    // Make sure the stored checksum is up to date
+    fs.updateChecksum(ref);
+
     auto& node = fs.fetch(ref);
     isize word = pos / 4;
     isize sword = word - (node.bsize() / 4);
@@ -694,6 +705,12 @@ FSDoctor::rectify(BlockNr ref, bool strict)
             }
         }
     }
+
+    // Patched bitmap blocks invalidate the allocator's bitmap copy
+    if (node.is(FSBlockType::BITMAP)) allocator.invalidateBitmap();
+
+    // Patched directory blocks invalidate the cached lookups
+    if (node.hasHashTable() || node.isHashable()) fs.forgetLookups();
 }
 
 void
@@ -701,12 +718,8 @@ FSDoctor::rectifyBitmap(bool strict)
 {
     xrayBitmap(strict);
 
-    for (auto &it : diagnosis.unusedButAllocated) {
-        allocator.markAsFree(BlockNr(it));
-    }
-    for (auto &it : diagnosis.usedButUnallocated) {
-        allocator.markAsAllocated(BlockNr(it));
-    }
+    allocator.markAsFree(diagnosis.unusedButAllocated);
+    allocator.markAsAllocated(diagnosis.usedButUnallocated);
 }
 
 string
@@ -752,6 +765,7 @@ FSDoctor::createUsageMap(u8 *buffer, isize len) const
             if (pri[buffer[pos]] < pri[val]) buffer[pos] = val;
             if (pri[buffer[pos]] == pri[val] && pos > 0 && buffer[pos-1] != val) buffer[pos] = val;
         }
+        fs.trim();
     }
 
     // Fill gaps
@@ -780,6 +794,7 @@ FSDoctor::createAllocationMap(u8 *buffer, isize len) const
         if (auto type = fs.typeOf(BlockNr(i)); type != FSBlockType::EMPTY) {
             buffer[i * (len - 1) / (max - 1)] = 1;
         }
+        fs.trim();
     }
 
     // Mark all erroneous blocks
@@ -811,6 +826,7 @@ FSDoctor::createHealthMap(u8 *buffer, isize len) const
         if (auto type = fs.typeOf(BlockNr(i)); type != FSBlockType::EMPTY) {
             buffer[i * (len - 1) / (max - 1)] = 1;
         }
+        fs.trim();
     }
 
     // Mark all erroneous blocks
@@ -33,6 +33,9 @@ FSExporter::exportVolume(TrackDevice &dev) const
     if (fs.getTraits().blocks != dev.capacity())
         throw FSError(FSError::FS_WRONG_CAPACITY);
 
+    // Compute all postponed checksums
+    fs.updateChecksums();
+
     for (isize i = 0; i < traits.blocks; ++i)
         dev.writeBlock(fs.fetch(i).data(), i);
 }
@@ -71,6 +74,9 @@ FSExporter::exportBlocks(BlockNr first, BlockNr last, u8 *dst, isize size) const
     // Wipe out the target buffer
     std::memset(dst, 0, size);
 
+    // Compute all postponed checksums
+    fs.updateChecksums();
+
     // Export all blocks
     for (BlockNr nr = first; nr <= last; nr++) {
 
@@ -95,6 +101,9 @@ FSExporter::exportBlocks(BlockNr first, BlockNr last, const fs::path &path) cons
         throw IOError(IOError::FILE_CANT_CREATE, path);
     }
 
+    // Compute all postponed checksums
+    fs.updateChecksums();
+
     for (BlockNr i = first; i <= last; i++) {
 
         auto *data = fs.fetch(i).data();
@@ -47,6 +47,10 @@ FSImporter::importVolume(const u8 *src, isize size)
         }
     }
 
+    // The bitmap blocks and directory blocks have been overwritten
+    fs.allocator.invalidateBitmap();
+    fs.forgetLookups();
+
     // Print some debug information
     loginfo(FS_DEBUG, "Success\n");
 }
@@ -145,6 +149,10 @@ FSImporter::importBlock(BlockNr nr, const fs::path &path)
     if (!stream) {
         throw IOError(IOError::FILE_CANT_READ, path);
     }
+
+    // The imported block might be a bitmap block or a directory block
+    fs.allocator.invalidateBitmap();
+    fs.forgetLookups();
 }
 
 }
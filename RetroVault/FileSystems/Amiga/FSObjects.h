@@ -158,6 +158,11 @@ struct FSStat {
 
     // Access statistics
     isize generation;
+
+    // Block cache statistics
+    isize cacheHits;
+    isize cacheMisses;
+    isize cacheEvictions;
 };
 
 struct FSBootStat {
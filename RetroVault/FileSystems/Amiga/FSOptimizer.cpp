@@ -0,0 +1,273 @@
+// -----------------------------------------------------------------------------
+// This file is part of RetroVault
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the Mozilla Public License v2
+//
+// See https://mozilla.org/MPL/2.0 for license information
+// -----------------------------------------------------------------------------
+
+#include "config.h"
+#include "FileSystems/Amiga/FSOptimizer.h"
+#include "FileSystems/Amiga/FileSystem.h"
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace retro::vault::amiga {
+
+FSOptimizer::FSOptimizer(FileSystem& fs, FSAllocator &a) : FSService(fs), allocator(a)
+{
+
+}
+
+std::vector<BlockNr>
+FSOptimizer::layout(BlockNr fhb) const
+{
+    auto listBlocks = fs.collectListBlocks(fhb);
+    auto dataBlocks = fs.collectDataBlocks(fhb);
+    auto numRefs = isize(traits.bsize / 4 - 56);
+
+    std::vector<BlockNr> result;
+    result.reserve(listBlocks.size() + dataBlocks.size());
+
+    // Arrange the blocks the same way the allocator hands them out
+    auto data = dataBlocks.begin();
+    auto takeData = [&](isize count) {
+        for (; count > 0 && data != dataBlocks.end(); count--) result.push_back(*data++);
+    };
+
+    takeData(numRefs);
+
+    if (traits.ofs()) {
+
+        // Header block -> Data blocks -> List block -> Data blocks ...
+        for (auto &it : listBlocks) { result.push_back(it); takeData(numRefs); }
+
+    } else {
+
+        // Header block -> Data blocks -> All list blocks -> All remaining data blocks
+        result.insert(result.end(), listBlocks.begin(), listBlocks.end());
+    }
+    takeData(isize(dataBlocks.size()));
+
+    return result;
+}
+
+bool
+FSOptimizer::isContiguous(const std::vector<BlockNr> &blocks)
+{
+    for (usize i = 1; i < blocks.size(); i++) {
+        if (blocks[i] != blocks[i - 1] + 1) return false;
+    }
+    return true;
+}
+
+isize
+FSOptimizer::fragmentedFiles() const
+{
+    isize result = 0;
+
+    for (auto nr : collectNodes()) {
+        if (fs.fetch(nr).isFile() && !isContiguous(nr)) result++;
+    }
+    return result;
+}
+
+bool
+FSOptimizer::optimize(isize budget)
+{
+    isize moves = 0;
+    bool pending = false;
+
+    // Phase 1: Move directory and file header blocks towards the root block
+    auto root = fs.root();
+    for (auto nr : collectNodes()) {
+
+        if (fs.isPinned(nr)) continue;
+
+        auto to = allocator.nearestFree(root);
+        if (to < 0 || std::abs(to - root) >= std::abs(nr - root)) continue;
+
+        if (moves >= budget) { pending = true; break; }
+
+        relocateNode(nr, to);
+        moves++;
+    }
+
+    // Phase 2: Store the list and data blocks of each file in a single run
+    for (auto nr : collectNodes()) {
+
+        if (!fs.fetch(nr).isFile() || fs.isPinned(nr)) continue;
+
+        auto blocks = layout(nr);
+        auto count = isize(blocks.size());
+        if (isContiguous(blocks)) continue;
+
+        if (moves > 0 && moves + count > budget) { pending = true; continue; }
+
+        // Files are skipped if no free run is large enough
+        if (auto run = allocator.allocateRun(count)) {
+
+            relocateFile(nr, blocks, *run);
+            moves += count;
+        }
+    }
+
+    loginfo(FS_DEBUG, "Moved %ld blocks (%s)\n", moves, pending ? "pending" : "done");
+    return !pending;
+}
+
+std::vector<BlockNr>
+FSOptimizer::collectNodes() const
+{
+    std::vector<BlockNr> result;
+    std::vector<BlockNr> dirs = { fs.root() };
+    std::unordered_set<BlockNr> visited;
+
+    // Traverse the directory tree in breadth-first order
+    for (usize i = 0; i < dirs.size(); i++) {
+
+        for (auto nr : fs.collectHashedBlocks(dirs[i])) {
+
+            if (!visited.insert(nr).second) continue;
+
+            result.push_back(nr);
+            if (fs.fetch(nr).isDirectory()) dirs.push_back(nr);
+        }
+    }
+
+    return result;
+}
+
+void
+FSOptimizer::relocateNode(BlockNr nr, BlockNr to)
+{
+    auto &src = fs.fetch(nr);
+
+    loginfo(FS_DEBUG, "Moving node %ld to %ld\n", nr, to);
+
+    // Copy the block
+    allocator.markAsAllocated(std::vector<BlockNr> { to });
+    auto &dst = fs.fetch(to).mutate();
+    dst.type = src.type;
+    std::memcpy(dst.data(), src.data(), traits.bsize);
+    dst.setHeaderKey(u32(to));
+    dst.updateChecksum();
+
+    // Redirect the hash table entry or the hash chain link pointing to the block
+    auto &parent = fs.fetch(src.getParentDirRef());
+    auto bucket = src.hashValue() % parent.hashTableSize();
+
+    if (parent.getHashRef(bucket) == nr) {
+
+        auto &block = parent.mutate();
+        block.setHashRef(bucket, to);
+        block.updateChecksum();
+
+    } else {
+
+        for (auto pred : fs.collectHashedBlocks(parent.nr, bucket)) {
+
+            if (fs.fetch(pred).getNextHashRef() == nr) {
+
+                auto &block = fs.fetch(pred).mutate();
+                block.setNextHashRef(to);
+                block.updateChecksum();
+                break;
+            }
+        }
+    }
+
+    // Redirect all back references
+    auto redirect = [&](BlockNr ref, auto setter) {
+
+        auto &block = fs.fetch(ref).mutate();
+        (block.*setter)(to);
+        block.updateChecksum();
+    };
+
+    if (dst.isDirectory()) {
+
+        for (auto child : fs.collectHashedBlocks(to)) redirect(child, &FSBlock::setParentDirRef);
+
+    } else {
+
+        for (auto ref : fs.collectListBlocks(to)) redirect(ref, &FSBlock::setFileHeaderRef);
+
+        if (traits.ofs()) {
+            for (auto ref : fs.collectDataBlocks(to)) redirect(ref, &FSBlock::setFileHeaderRef);
+        }
+    }
+
+    // Keep the working directory
+    if (fs.pwd() == nr) fs.cd(to);
+
+    // Cached lookups may still refer to the old location
+    fs.forgetLookups();
+
+    allocator.deallocateBlock(nr);
+}
+
+void
+FSOptimizer::relocateFile(BlockNr fhb, const std::vector<BlockNr> &blocks, Range<BlockNr> run)
+{
+    assert(run.size() == isize(blocks.size()));
+
+    loginfo(FS_DEBUG, "Moving %ld blocks of file %ld to %ld\n", run.size(), fhb, run.lower);
+
+    std::unordered_map<BlockNr, BlockNr> map;
+    for (usize i = 0; i < blocks.size(); i++) map[blocks[i]] = run.lower + BlockNr(i);
+
+    auto remap = [&](BlockNr ref) {
+
+        auto it = map.find(ref);
+        return it == map.end() ? ref : it->second;
+    };
+
+    auto remapDataBlockRefs = [&](FSBlock &block) {
+
+        auto num = std::min(block.getNumDataBlockRefs(), block.getMaxDataBlockRefs());
+        for (isize i = 0; i < num; i++) block.setDataBlockRef(i, remap(block.getDataBlockRef(i)));
+    };
+
+    // Copy all blocks and redirect the references between them
+    for (auto &[from, to] : map) {
+
+        auto &src = fs.fetch(from);
+        auto &dst = fs.fetch(to).mutate();
+        dst.type = src.type;
+        std::memcpy(dst.data(), src.data(), traits.bsize);
+
+        switch (dst.type) {
+
+            case FSBlockType::FILELIST:
+
+                dst.setHeaderKey(u32(to));
+                dst.setNextListBlockRef(remap(dst.getNextListBlockRef()));
+                remapDataBlockRefs(dst);
+                dst.updateChecksum();
+                break;
+
+            case FSBlockType::DATA_OFS:
+
+                dst.setNextDataBlockRef(remap(dst.getNextDataBlockRef()));
+                dst.updateChecksum();
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // Redirect the references in the file header block
+    auto &header = fs.fetch(fhb).mutate();
+    header.setFirstDataBlockRef(remap(header.getFirstDataBlockRef()));
+    header.setNextListBlockRef(remap(header.getNextListBlockRef()));
+    remapDataBlockRefs(header);
+    header.updateChecksum();
+
+    allocator.deallocateBlocks(blocks);
+}
+
+}
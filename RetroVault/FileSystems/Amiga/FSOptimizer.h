@@ -0,0 +1,65 @@
+// -----------------------------------------------------------------------------
+// This file is part of RetroVault
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the Mozilla Public License v2
+//
+// See https://mozilla.org/MPL/2.0 for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "FileSystems/Amiga/FSService.h"
+#include "utl/primitives/Range.h"
+
+namespace retro::vault::amiga {
+
+class FSOptimizer final : public FSService {
+
+    class FSAllocator &allocator;
+
+public:
+
+    explicit FSOptimizer(FileSystem& fs, FSAllocator &a);
+
+
+    //
+    // Analyzing the block layout
+    //
+
+public:
+
+    // Returns the list and data blocks of a file in the order they are read
+    std::vector<BlockNr> layout(BlockNr fhb) const;
+
+    // Checks if the list and data blocks of a file form a single run
+    bool isContiguous(BlockNr fhb) const { return isContiguous(layout(fhb)); }
+    static bool isContiguous(const std::vector<BlockNr> &blocks);
+
+    // Returns the number of files that are not stored contiguously
+    isize fragmentedFiles() const;
+
+
+    //
+    // Optimizing the block layout
+    //
+
+public:
+
+    // Moves up to 'budget' blocks. Returns true if no more work is pending.
+    // A single file exceeding the budget is moved if nothing else was moved.
+    bool optimize(isize budget = std::numeric_limits<isize>::max());
+
+private:
+
+    // Collects all directory and file header blocks (parents come first)
+    std::vector<BlockNr> collectNodes() const;
+
+    // Moves a directory or file header block to a free block
+    void relocateNode(BlockNr nr, BlockNr to);
+
+    // Moves the list and data blocks of a file into an allocated run
+    void relocateFile(BlockNr fhb, const std::vector<BlockNr> &blocks, Range<BlockNr> run);
+};
+
+}
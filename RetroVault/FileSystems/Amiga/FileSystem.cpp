@@ -196,7 +196,11 @@ FileSystem::stat() const noexcept
         .bDate          = rb.getCreationDate(),
         .mDate          = rb.getModificationDate(),
 
-        .generation     = 0 // TODO
+        .generation     = generation,
+
+        .cacheHits      = cache.cacheHits(),
+        .cacheMisses    = cache.cacheMisses(),
+        .cacheEvictions = cache.cacheEvictions()
     };
 
     return result;
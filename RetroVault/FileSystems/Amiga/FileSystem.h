@@ -98,6 +98,7 @@
 #include "FileSystems/Amiga/FSAllocator.h"
 #include "FileSystems/Amiga/FSImporter.h"
 #include "FileSystems/Amiga/FSExporter.h"
+#include "FileSystems/Amiga/FSOptimizer.h"
 #include "FileSystems/Amiga/FSTree.h"
 #include "FileSystems/FSError.h"
 #include "FileSystems/PosixViewTypes.h"
@@ -110,6 +111,7 @@ namespace retro::vault::amiga {
 class FileSystem : public Loggable {
 
     friend struct FSBlock;
+    friend class FSImporter;
 
     // Immutable file system properties
     FSTraits traits;
@@ -136,6 +138,41 @@ class FileSystem : public Loggable {
     vector<BlockNr> bmBlocks;
     vector<BlockNr> bmExtBlocks;
 
+    // Block sequence of a file (list blocks and data blocks in file order)
+    struct BlockMap {
+
+        optional<vector<BlockNr>> listBlocks;
+        optional<vector<BlockNr>> dataBlocks;
+
+        // Returns the approximate memory footprint in bytes
+        isize bytes() const {
+            return isize(sizeof(BlockMap)) + isize(sizeof(BlockNr)) *
+            isize((listBlocks ? listBlocks->size() : 0) + (dataBlocks ? dataBlocks->size() : 0));
+        }
+    };
+
+    // Cached block sequences (all maps belong to the same generation)
+    mutable std::unordered_map<BlockNr, BlockMap> blockMaps;
+    mutable isize blockMapGeneration = -1;
+
+    // Memory occupied by all block maps in bytes
+    mutable std::atomic<isize> blockMapBytes = 0;
+
+    // Block maps may occupy up to this fraction of the cache budget
+    static constexpr isize blockMapShare = 4;
+
+    // Cached directory lookups (parent block -> uppercased name -> item)
+    mutable std::unordered_map<BlockNr, std::unordered_map<string, BlockNr>> dentries;
+
+    // Cached failed lookups (parent block -> uppercased names)
+    mutable std::unordered_map<BlockNr, std::unordered_set<string>> misses;
+
+    // Maximum number of failed lookups remembered per directory
+    static constexpr isize maxMisses = 256;
+
+    // Protects the cached block sequences and lookups from concurrent readers
+    mutable std::mutex lookupLock;
+
 
     // Path layer
 
@@ -156,6 +193,9 @@ public:
     // Error checking, rectification
     FSDoctor doctor = FSDoctor(*this, allocator);
 
+    // Defragmentation
+    FSOptimizer optimizer = FSOptimizer(*this, allocator);
+
     // Contracts
     FSRequire require = FSRequire(*this);
     FSEnsure ensure = FSEnsure(*this);
@@ -176,6 +216,7 @@ public:
     FileSystem& operator=(FileSystem &&) = delete;
 
     void stepGeneration() { ++generation; }
+    isize getGeneration() const noexcept { return generation; }
     
 
     //
@@ -266,6 +307,25 @@ public:
 
     // Invalidates all cached blocks
     void invalidate();
+
+    // Computes postponed checksums (call before reading checksums directly)
+    void updateChecksum(BlockNr nr) { cache.updateChecksum(nr); }
+    void updateChecksums() { cache.updateChecksums(); }
+
+    // Limits the memory consumed by the block cache (0 = unlimited)
+    isize getCacheBudget() const noexcept { return cache.getBudget(); }
+    void setCacheBudget(isize bytes) noexcept { cache.setBudget(bytes); }
+
+    // Protects a block from being evicted from the block cache
+    void pin(BlockNr nr) noexcept { cache.pin(nr); }
+    void unpin(BlockNr nr) noexcept { cache.unpin(nr); }
+    bool isPinned(BlockNr nr) const noexcept { return cache.isPinned(nr); }
+
+    // Checks whether the block cache or the block maps have outgrown the budget
+    bool exceedsCacheBudget() const noexcept;
+
+    // Evicts blocks and block maps from the caches (call only if no references are held)
+    void trim() const noexcept;
     
     // Operator overload for fetch
     const FSBlock &operator[](size_t nr) { return cache.fetch(BlockNr(nr)); }
@@ -309,6 +369,9 @@ public:
     optional<BlockNr> searchdir(BlockNr at, const FSName &name) const;
     vector<BlockNr> searchdir(BlockNr at, const FSPattern &pattern) const;
 
+    // Looks up a specific directory item (reports the cause of a miss without throwing)
+    FSResult<BlockNr> lookup(BlockNr at, const FSName &name) const;
+
     // Creates a new directory
     BlockNr mkdir(BlockNr at, const FSName &name);
 
@@ -321,8 +384,17 @@ public:
     // Removes an existing directory entry
     void unlink(BlockNr fhb);
 
+    // Discards all cached directory lookups (call after modifying blocks directly)
+    void forgetLookups() noexcept;
+
 private:
 
+    // Discards the cached lookup of a single directory item
+    void forgetLookup(BlockNr parent, const FSName &name) noexcept;
+
+    // Discards all cached failed lookups of a directory
+    void forgetMisses(BlockNr parent) noexcept;
+
     // Adds a hash-table entry for a given item
     void addToHashTable(BlockNr parent, BlockNr ref);
 
@@ -364,6 +436,12 @@ public:
     void replace(BlockNr at, const Buffer<u8> &data);
     void replace(BlockNr at, const string &str);
 
+    // Reads data from a file at a certain offset
+    isize read(BlockNr at, u8 *buf, isize size, isize offset) const;
+
+    // Writes data into an existing file at a certain offset (grows the file if needed)
+    isize write(BlockNr at, const u8 *buf, isize size, isize offset);
+
 private:
 
     // Main replace function
@@ -409,6 +487,13 @@ public:
 
 private:
 
+    // Returns the cached block sequence of a file (maps of older generations are discarded).
+    // The caller must hold the lookup lock.
+    BlockMap &blockMap(BlockNr nr) const;
+
+    // Checks whether the block maps occupy more than their share of the budget
+    bool blockMapsExceedBudget() const noexcept;
+
     // Follows a linked list and collects all blocks
     using BlockIterator = std::function<const FSBlock *(const FSBlock *)>;
     vector<const FSBlock *> collect(const FSBlock &block, BlockIterator succ) const;
@@ -465,6 +550,9 @@ public:
     optional<BlockNr> trySeek(const string &path) const { return trySeek(FSPath(path)); }
     optional<BlockNr> trySeek(const fs::path &path) const { return trySeek(FSPath(path)); }
 
+    // Resolves a path by name (reports the cause of a miss without throwing)
+    FSResult<BlockNr> lookup(const FSPath &path) const;
+
     // Resolves a path by name (may throw)
     BlockNr seek(const FSPath &path) const;
     BlockNr seek(const char *path) const { return seek(FSPath(path)); }
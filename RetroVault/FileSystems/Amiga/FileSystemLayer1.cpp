@@ -52,12 +52,51 @@ void
 FileSystem::flush()
 {
     cache.flush();
+
+    // All blocks are clean now and can be evicted if necessary
+    trim();
+}
+
+bool
+FileSystem::exceedsCacheBudget() const noexcept
+{
+    return cache.exceedsBudget() || blockMapsExceedBudget();
+}
+
+bool
+FileSystem::blockMapsExceedBudget() const noexcept
+{
+    auto budget = cache.getBudget();
+    return budget != 0 && blockMapBytes > std::max(isize(1), budget / blockMapShare);
+}
+
+void
+FileSystem::trim() const noexcept
+{
+    cache.trim();
+
+    if (!blockMapsExceedBudget()) return;
+
+    // Drop block maps until they fit (they are recomputed on demand)
+    std::lock_guard<std::mutex> guard(lookupLock);
+    for (auto it = blockMaps.begin(); it != blockMaps.end() && blockMapsExceedBudget();) {
+
+        blockMapBytes -= it->second.bytes();
+        it = blockMaps.erase(it);
+    }
 }
 
 void
 FileSystem::invalidate()
 {
     cache.invalidate();
+    allocator.invalidateBitmap();
+
+    std::lock_guard<std::mutex> guard(lookupLock);
+    blockMaps.clear();
+    blockMapBytes = 0;
+    dentries.clear();
+    misses.clear();
 }
 
 }
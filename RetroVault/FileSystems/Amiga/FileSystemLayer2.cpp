@@ -20,19 +20,21 @@ FileSystem::format(FSFormat dos) {
     traits.dos = dos;
     if (dos == FSFormat::NODOS) return;
 
+    // The bitmap blocks are about to be recreated
+    allocator.invalidateBitmap();
+    forgetLookups();
+
     // Perform some consistency checks
     assert(blocks() > 2);
     assert(rootBlock > 0);
 
+    // Wipe out all blocks (the device is zeroed with the next flush)
+    cache.wipe(Range<BlockNr>{ 0, traits.blocks });
+
     // Create boot blocks
     cache.modify(0).init(FSBlockType::BOOT);
     cache.modify(1).init(FSBlockType::BOOT);
 
-    // Wipe out all other blocks
-    for (isize i = 2; i < traits.blocks; i++) {
-        (*this)[i].mutate().init(FSBlockType::EMPTY);
-    }
-
     // Create the root block
     (*this)[rootBlock].mutate().init(FSBlockType::ROOT);
 
@@ -56,17 +58,17 @@ FileSystem::format(FSFormat dos) {
     // Add all bitmap block references
     (*this)[rootBlock].mutate().addBitmapBlockRefs(bmBlocks);
 
-    // Mark free blocks as free in the bitmap block
-    // TODO: SPEED THIS UP
-    for (isize i = 0; i < blocks(); i++) {
-        if (cache.isEmpty(BlockNr(i))) allocator.markAsFree(BlockNr(i));
-    }
+    // Mark all blocks as free except the ones created above
+    std::vector<BlockNr> used = { rootBlock };
+    used.insert(used.end(), bmBlocks.begin(), bmBlocks.end());
+    used.insert(used.end(), bmExtBlocks.begin(), bmExtBlocks.end());
+    allocator.setAllocRange(Range<BlockNr>{ 2, traits.blocks }, 1);
+    allocator.markAsAllocated(used);
 
     // Rectify checksums
     fetch(0).mutate().updateChecksum();
     fetch(1).mutate().updateChecksum();
     (*this)[rootBlock].mutate().updateChecksum();
-    for (auto& ref : bmBlocks) { (*this)[ref].mutate().updateChecksum(); }
     for (auto& ref : bmExtBlocks) { (*this)[ref].mutate().updateChecksum(); }
 
     // Set the current directory
@@ -134,16 +136,36 @@ FileSystem::getItems(BlockNr at) const
 
 optional<BlockNr>
 FileSystem::searchdir(BlockNr at, const FSName &name) const
+{
+    if (auto result = lookup(at, name)) return *result;
+    return {};
+}
+
+FSResult<BlockNr>
+FileSystem::lookup(BlockNr at, const FSName &name) const
 {
     std::unordered_set<BlockNr> visited;
 
+    // Check if the item has been looked up before
+    auto key = utl::uppercased(name.cpp_str());
+    {   std::lock_guard<std::mutex> guard(lookupLock);
+
+        if (auto dir = dentries.find(at); dir != dentries.end()) {
+            if (auto it = dir->second.find(key); it != dir->second.end()) return it->second;
+        }
+        if (auto dir = misses.find(at); dir != misses.end()) {
+            if (dir->second.contains(key)) return std::unexpected(FSError::FS_NOT_FOUND);
+        }
+    }
+
     // Only proceed if a hash table is present
-    auto &top = fetch(at);
-    if (!top.hasHashTable()) return {};
+    auto *top = tryFetch(at);
+    if (!top) return std::unexpected(FSError::FS_OUT_OF_RANGE);
+    if (!top->hasHashTable()) return std::unexpected(FSError::FS_NOT_A_DIRECTORY);
 
     // Compute the table position and read the item
-    u32 hash = name.hashValue(traits.dos) % top.hashTableSize();
-    BlockNr ref = top.getHashRef(hash);
+    u32 hash = name.hashValue(traits.dos) % top->hashTableSize();
+    BlockNr ref = top->getHashRef(hash);
 
     // Traverse the linked list until the item has been found
     while (ref && visited.find(ref) == visited.end())  {
@@ -151,13 +173,23 @@ FileSystem::searchdir(BlockNr at, const FSName &name) const
         auto *block = tryFetch(ref, { FSBlockType::USERDIR, FSBlockType::FILEHEADER });
         if (block == nullptr) break;
 
-        if (block->isNamed(name)) return block->nr;
+        if (block->isNamed(name)) {
+
+            std::lock_guard<std::mutex> guard(lookupLock);
+            return dentries[at][key] = block->nr;
+        }
 
         visited.insert(ref);
         ref = block->getNextHashRef();
     }
 
-    return {};
+    // Remember the failed lookup (start over if too many names have piled up)
+    std::lock_guard<std::mutex> guard(lookupLock);
+    auto &names = misses[at];
+    if (isize(names.size()) >= maxMisses) names.clear();
+    names.insert(key);
+
+    return std::unexpected(FSError::FS_NOT_FOUND);
 }
 
 BlockNr
@@ -236,6 +268,33 @@ FileSystem::unlink(BlockNr node)
     deleteFromHashTable(node);
 }
 
+void
+FileSystem::forgetLookups() noexcept
+{
+    std::lock_guard<std::mutex> guard(lookupLock);
+
+    dentries.clear();
+    misses.clear();
+}
+
+void
+FileSystem::forgetLookup(BlockNr parent, const FSName &name) noexcept
+{
+    std::lock_guard<std::mutex> guard(lookupLock);
+
+    if (auto dir = dentries.find(parent); dir != dentries.end()) {
+        dir->second.erase(utl::uppercased(name.cpp_str()));
+    }
+}
+
+void
+FileSystem::forgetMisses(BlockNr parent) noexcept
+{
+    std::lock_guard<std::mutex> guard(lookupLock);
+
+    misses.erase(parent);
+}
+
 void
 FileSystem::addToHashTable(BlockNr parent, BlockNr ref)
 {
@@ -245,6 +304,9 @@ FileSystem::addToHashTable(BlockNr parent, BlockNr ref)
     auto &pr = fetch(ref);
     if (!pr.isHashable()) throw FSError(FSError::FS_WRONG_BLOCK_TYPE);
 
+    forgetLookup(parent, pr.name());
+    forgetMisses(parent);
+
     // Read the linked list from the proper hash-table bucket
     u32 hash = pr.hashValue() % pp.hashTableSize();
     auto chain = collectHashedBlocks(pp.nr, hash);
@@ -273,6 +335,14 @@ FileSystem::deleteFromHashTable(BlockNr ref)
     auto &pp = fetch(pr.getParentDirRef());
     if (!pp.hasHashTable()) throw FSError(FSError::FS_WRONG_BLOCK_TYPE);
 
+    forgetLookup(pp.nr, pr.name());
+    forgetMisses(pp.nr);
+    {   std::lock_guard<std::mutex> guard(lookupLock);
+
+        dentries.erase(ref);
+        misses.erase(ref);
+    }
+
     // Read the linked list from the proper hash-table bucket
     u32 hash = pr.hashValue() % pp.hashTableSize();
     auto chain = collectHashedBlocks(pp.nr, hash);
@@ -397,11 +467,60 @@ FileSystem::copy(BlockNr item, BlockNr dest, const FSName &name)
     require.file(item);
     require.directory(dest);
 
-    // Read source file
-    Buffer<u8> buffer; fetch(item).extractData(buffer);
+    // Number of data block references held in a file header or list block
+    const isize numRefs = ((traits.bsize / 4) - 56);
+
+    // Number of payload bytes held in a data block
+    const isize capacity = traits.ofs() ? traits.bsize - 24 : traits.bsize;
+
+    auto size = isize(fetch(item).getFileSize());
+    auto source = collectDataBlocks(item);
+
+    // Only proceed if the source file is intact
+    if (isize(source.size()) * capacity < size) {
+        throw FSError(FSError::FS_CORRUPTED, "Missing data blocks");
+    }
+
+    // Create an empty file at the destination
+    auto fhb = createFile(dest, name);
+    auto &fhbNode = fetch(fhb).mutate();
+    fhbNode.setFileSize(u32(size));
+
+    // Allocate all blocks at once
+    std::vector<BlockNr> listBlocks, dataBlocks;
+    allocator.allocateFileBlocks(size, listBlocks, dataBlocks);
+
+    for (usize i = 0; i < listBlocks.size(); i++) {
+
+        // Add a list block
+        addFileListBlock(listBlocks[i], fhb, i == 0 ? fhb : listBlocks[i-1]);
+    }
+
+    for (isize i = 0; i < (isize)dataBlocks.size(); i++) {
+
+        // Copy the data block from the cache
+        auto &src = fetch(source[i]);
+        auto &dst = fetch(dataBlocks[i]).mutate();
+        dst.type = src.type;
+        std::memcpy(dst.data(), src.data(), traits.bsize);
+
+        // Patch the data block header
+        if (dst.type == FSBlockType::DATA_OFS) {
+
+            dst.setFileHeaderRef(fhb);
+            dst.setDataBlockNr(i + 1);
+            dst.setNextDataBlockRef(i + 1 < (isize)dataBlocks.size() ? dataBlocks[i + 1] : 0);
+            dst.updateChecksum();
+        }
+
+        // Link the data block
+        auto &lb = fetch((i < numRefs) ? fhb : listBlocks[i / numRefs - 1]);
+        lb.mutate().addDataBlockRef(dataBlocks[0], dataBlocks[i]);
+    }
 
-    // Create file at destination
-    createFile(dest, name, buffer);
+    // Rectify checksums
+    for (auto &it : listBlocks) { fetch(it).mutate().updateChecksum(); }
+    fhbNode.updateChecksum();
 }
 
 void
@@ -494,6 +613,154 @@ FileSystem::replace(BlockNr fhb,
     return fhb;
 }
 
+isize
+FileSystem::read(BlockNr at, u8 *buf, isize size, isize offset) const
+{
+    if (offset < 0) throw FSError(FSError::FS_OUT_OF_RANGE);
+
+    auto &header = fetch(at, FSBlockType::FILEHEADER);
+
+    // Number of data block references held in a file header or list block
+    const isize numRefs = ((traits.bsize / 4) - 56);
+
+    // Number of data bytes held in a data block
+    const isize capacity = traits.ofs() ? traits.bsize - 24 : traits.bsize;
+
+    // Crop the requested range at the end of the file
+    size = std::min(size, isize(header.getFileSize()) - offset);
+    if (size <= 0) return 0;
+
+    // Collect all blocks holding data block references (in file order)
+    auto tables = collectListBlocks(at);
+    tables.insert(tables.begin(), at);
+
+    auto index = offset / capacity;
+    isize total = 0;
+
+    for (isize pos = offset % capacity; total < size; index++, pos = 0) {
+
+        if (index / numRefs >= isize(tables.size())) {
+            throw FSError(FSError::FS_CORRUPTED, "Missing file list block");
+        }
+
+        // Copy data bytes
+        auto &table = fetch(tables[index / numRefs]);
+        auto &block = fetch(table.getDataBlockRef(index % numRefs));
+        total += block.readData(buf + total, pos, size - total);
+    }
+
+    return total;
+}
+
+isize
+FileSystem::write(BlockNr at, const u8 *buf, isize size, isize offset)
+{
+    if (offset < 0) throw FSError(FSError::FS_OUT_OF_RANGE);
+    if (size <= 0) return 0;
+
+    auto &header = fetch(at, FSBlockType::FILEHEADER);
+
+    // Number of data block references held in a file header or list block
+    const isize numRefs = ((traits.bsize / 4) - 56);
+
+    // Number of data bytes held in a data block and the position of the first byte
+    const isize capacity = traits.ofs() ? traits.bsize - 24 : traits.bsize;
+    const isize start = traits.bsize - capacity;
+
+    auto oldSize = isize(header.getFileSize());
+    auto newSize = std::max(oldSize, offset + size);
+    auto oldBlocks = (oldSize + capacity - 1) / capacity;
+    auto newBlocks = (newSize + capacity - 1) / capacity;
+
+    // Collect all blocks holding data block references (in file order)
+    auto tables = collectListBlocks(at);
+    tables.insert(tables.begin(), at);
+
+    // Returns the i-th data block of the file
+    auto dataBlock = [&](isize i) {
+        return BlockNr(fetch(tables[i / numRefs]).getDataBlockRef(i % numRefs));
+    };
+
+    // Collect all modified blocks to update their checksums once at the end
+    std::vector<BlockNr> touched = { at };
+
+    if (newBlocks > oldBlocks) {
+
+        // Allocate the missing list and data blocks at the end of the file
+        std::vector<BlockNr> listBlocks, dataBlocks;
+        allocator.allocateFileBlocks(newSize, isize(tables.size()) - 1, oldBlocks, listBlocks, dataBlocks);
+
+        for (auto &it : listBlocks) {
+
+            // Add a list block
+            addFileListBlock(it, at, tables.back());
+            touched.push_back(tables.back());
+            touched.push_back(it);
+            tables.push_back(it);
+        }
+
+        auto first = oldBlocks ? dataBlock(0) : dataBlocks.front();
+        auto prev = oldBlocks ? dataBlock(oldBlocks - 1) : at;
+
+        for (isize i = oldBlocks; i < newBlocks; i++) {
+
+            // Add a data block and link it
+            auto nr = dataBlocks[i - oldBlocks];
+            auto &table = fetch(tables[i / numRefs]).mutate();
+            addDataBlock(nr, i + 1, at, prev);
+            table.addDataBlockRef(first, nr);
+            touched.push_back(prev);
+            touched.push_back(nr);
+            touched.push_back(table.nr);
+            prev = nr;
+        }
+    }
+
+    if (newSize > oldSize) {
+
+        // Clear the bytes behind the old end of file (the gap is filled with 0)
+        if (auto used = oldSize % capacity; used) {
+
+            auto &block = fetch(dataBlock(oldBlocks - 1)).mutate();
+            std::memset(block.data() + start + used, 0, capacity - used);
+            touched.push_back(block.nr);
+        }
+
+        // Update the byte counters of all OFS data blocks behind the old end of file
+        if (traits.ofs()) {
+
+            for (isize i = std::max(oldBlocks - 1, isize(0)); i < newBlocks; i++) {
+
+                auto &block = fetch(dataBlock(i)).mutate();
+                block.setDataBytesInBlock(u32(std::min(capacity, newSize - i * capacity)));
+                touched.push_back(block.nr);
+            }
+        }
+
+        header.mutate().setFileSize(u32(newSize));
+    }
+
+    // Copy the data into the affected data blocks
+    for (isize i = offset / capacity, pos = offset % capacity, remaining = size; remaining > 0; i++, pos = 0) {
+
+        auto &block = fetch(dataBlock(i)).mutate();
+        auto count = std::min(capacity - pos, remaining);
+
+        std::memcpy(block.data() + start + pos, buf, count);
+        touched.push_back(block.nr);
+
+        buf += count;
+        remaining -= count;
+    }
+
+    // Rectify checksums
+    std::ranges::sort(touched);
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (auto &it : touched) { fetch(it).mutate().updateChecksum(); }
+
+    return size;
+}
+
 BlockNr
 FileSystem::newUserDirBlock(const FSName &name)
 {
@@ -580,18 +847,19 @@ FileSystem::reclaim(BlockNr fhb)
     if (node.isDirectory()) {
 
         // Remove user directory block
-        allocator.markAsFree(node.nr); cache.erase(node.nr);
+        allocator.markAsFree(std::vector<BlockNr> { node.nr }); cache.erase(node.nr);
 
     } else if (node.isFile()) {
 
         // Collect all blocks occupied by this file
-        auto dataBlocks = collectDataBlocks(node.nr);
+        auto blocks = collectDataBlocks(node.nr);
         auto listBlocks = collectListBlocks(node.nr);
+        blocks.insert(blocks.end(), listBlocks.begin(), listBlocks.end());
+        blocks.push_back(node.nr);
 
         // Remove all blocks
-        allocator.markAsFree(node.nr); cache.erase(node.nr);
-        for (auto &it : dataBlocks) { allocator.markAsFree(it); cache.erase(it); }
-        for (auto &it : listBlocks) { allocator.markAsFree(it); cache.erase(it); }
+        allocator.markAsFree(blocks);
+        for (auto &it : blocks) { cache.erase(it); }
     }
 }
 
@@ -637,37 +905,67 @@ FileSystem::collect(const BlockNr nr, BlockIterator succ) const
     return result;
 }
 
+FileSystem::BlockMap &
+FileSystem::blockMap(BlockNr nr) const
+{
+    // Discard all maps if the file system has been modified in the meantime
+    if (blockMapGeneration != generation) {
+
+        blockMaps.clear();
+        blockMapBytes = 0;
+        blockMapGeneration = generation;
+    }
+
+    auto [it, inserted] = blockMaps.try_emplace(nr);
+    if (inserted) blockMapBytes += it->second.bytes();
+    return it->second;
+}
+
 std::vector<const FSBlock *>
 FileSystem::collectDataBlocks(const FSBlock &node) const
 {
-    // Gather all blocks containing data block references
-    auto blocks = collectListBlocks(node);
-    blocks.push_back(&node);
-
-    // Setup the result vector
     std::vector<const FSBlock *> result;
-    result.reserve(blocks.size() * node.getMaxDataBlockRefs());
-
-    // Crawl through blocks and collect all data block references
-    for (auto &it : blocks) {
 
-        isize num = std::min(it->getNumDataBlockRefs(), it->getMaxDataBlockRefs());
-        for (isize i = 0; i < num; i++) {
-            if (auto *ptr = it->getDataBlock(i); ptr) {
-                result.push_back(ptr);
-            }
-        }
-    }
+    for (auto &it : collectDataBlocks(node.nr)) result.push_back(&fetch(it));
     return result;
 }
 
 std::vector<BlockNr>
 FileSystem::collectDataBlocks(BlockNr ref) const
 {
+    {   std::lock_guard<std::mutex> guard(lookupLock);
+        if (auto &map = blockMap(ref); map.dataBlocks) return *map.dataBlocks;
+    }
+
     std::vector<BlockNr> result;
 
     if (auto *ptr = tryFetch(ref)) {
-        for (auto &it: collectDataBlocks(*ptr)) result.push_back(it->nr);
+
+        // Gather all blocks containing data block references (in file order)
+        auto blocks = collectListBlocks(ref);
+        blocks.insert(blocks.begin(), ref);
+
+        result.reserve(blocks.size() * ptr->getMaxDataBlockRefs());
+
+        // Crawl through blocks and collect all data block references
+        for (auto &nr : blocks) {
+
+            auto &it = fetch(nr);
+            isize num = std::min(it.getNumDataBlockRefs(), it.getMaxDataBlockRefs());
+            for (isize i = 0; i < num; i++) {
+                if (auto *data = it.getDataBlock(i); data) {
+                    result.push_back(data->nr);
+                }
+            }
+        }
+    }
+
+    // Concurrent readers may have collected the same blocks in the meantime
+    std::lock_guard<std::mutex> guard(lookupLock);
+    if (auto &map = blockMap(ref); !map.dataBlocks) {
+
+        map.dataBlocks = result;
+        blockMapBytes += isize(sizeof(BlockNr) * result.size());
     }
     return result;
 }
@@ -677,19 +975,31 @@ FileSystem::collectListBlocks(const FSBlock &node) const
 {
     std::vector<const FSBlock *> result;
 
-    if (auto *ptr = node.getNextListBlock()) {
-        result = collect(*ptr, [&](auto *block) { return block->getNextListBlock(); });
-    }
+    for (auto &it : collectListBlocks(node.nr)) result.push_back(&fetch(it));
     return result;
 }
 
 std::vector<BlockNr>
 FileSystem::collectListBlocks(const BlockNr ref) const
 {
+    {   std::lock_guard<std::mutex> guard(lookupLock);
+        if (auto &map = blockMap(ref); map.listBlocks) return *map.listBlocks;
+    }
+
     std::vector<BlockNr> result;
 
-    if (auto *ptr = tryFetch(ref)) {
-        for (auto &it: collectListBlocks(*ptr)) result.push_back(it->nr);
+    if (auto *ptr = tryFetch(ref); ptr) {
+        if (auto *next = ptr->getNextListBlock(); next) {
+            result = collect(next->nr, [&](auto *block) { return block->getNextListBlock(); });
+        }
+    }
+
+    // Concurrent readers may have collected the same blocks in the meantime
+    std::lock_guard<std::mutex> guard(lookupLock);
+    if (auto &map = blockMap(ref); !map.listBlocks) {
+
+        map.listBlocks = result;
+        blockMapBytes += isize(sizeof(BlockNr) * result.size());
     }
     return result;
 }
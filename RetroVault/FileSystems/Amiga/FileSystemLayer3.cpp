@@ -22,31 +22,41 @@ FileSystem::cd(BlockNr nr)
 optional<BlockNr>
 FileSystem::trySeek(const FSPath &path) const
 {
-    try {
+    if (auto result = lookup(path)) return *result;
+    return { };
+}
 
-        BlockNr current = path.absolute() ? root() : pwd();
+FSResult<BlockNr>
+FileSystem::lookup(const FSPath &path) const
+{
+    BlockNr current = path.absolute() ? root() : pwd();
 
-        for (const auto &p : path) {
+    for (const auto &p : path) {
 
-            // Check for special tokens
-            if (p == "." ) { continue; }
-            if (p == "..") { current = fetch(current).getParentDirRef(); continue; }
+        // Check for special tokens
+        if (p == "." ) { continue; }
+        if (p == "..") {
 
-            auto next = searchdir(current, p);
-            if (!next) return { };
+            auto *block = tryFetch(current);
+            if (!block) return std::unexpected(FSError::FS_OUT_OF_RANGE);
 
-            current = *next;
+            current = block->getParentDirRef();
+            continue;
         }
-        return current;
 
-    } catch (...) { return { }; }
+        auto next = lookup(current, p);
+        if (!next) return next;
+
+        current = *next;
+    }
+    return current;
 }
 
 BlockNr
 FileSystem::seek(const FSPath &path) const
 {
-    if (auto it = trySeek(path)) return *it;
-    throw FSError(FSError::FS_NOT_FOUND, path.cpp_str());
+    if (auto it = lookup(path)) return *it;
+    else throw FSError(it.error(), path.cpp_str());
 }
 
 vector<BlockNr>
@@ -59,69 +59,88 @@ PosixAdapter::stat() const noexcept
     };
 }
 
+FSResult<FSPosixAttr>
+PosixAdapter::tryAttr(const fs::path &path) const
+{
+    if (auto b = fs.lookup(FSPath(path))) return posixAttr(*b);
+    else return std::unexpected(b.error());
+}
+
+FSResult<FSPosixAttr>
+PosixAdapter::tryAttr(BlockNr node) const
+{
+    auto *block = fs.tryFetch(node);
+
+    if (!block) return std::unexpected(FSError::FS_OUT_OF_RANGE);
+    if (!block->isRoot() && !block->isHashable()) return std::unexpected(FSError::FS_NOT_FOUND);
+
+    return posixAttr(node);
+}
+
 FSPosixAttr
-PosixAdapter::attr(const fs::path &path) const
+PosixAdapter::posixAttr(BlockNr nr) const
 {
-    if (auto b = fs.trySeek(path)) {
-        
-        const auto &stat = fs.attr(*b);
-        
-        return FSPosixAttr {
-            
-            .size           = stat.size,
-            .blocks         = stat.blocks,
-            .prot           = stat.mode(),
-            .isDir          = stat.isDir,
-            
-            .btime          = stat.ctime.time(),
-            .atime          = stat.mtime.time(),
-            .mtime          = stat.mtime.time(),
-            .ctime          = stat.ctime.time()
-        };
-    }
-    
-    throw FSError(FSError::FS_NOT_FOUND);
+    const auto &stat = fs.attr(nr);
+
+    return FSPosixAttr {
+
+        .size           = stat.size,
+        .blocks         = stat.blocks,
+        .prot           = stat.mode(),
+        .isDir          = stat.isDir,
+
+        .btime          = stat.ctime.time(),
+        .atime          = stat.mtime.time(),
+        .mtime          = stat.mtime.time(),
+        .ctime          = stat.ctime.time()
+    };
 }
 
 void
 PosixAdapter::mkdir(const fs::path &path)
 {
-    if (wp) throw FSError(FSError::FS_READ_ONLY);
-    
-    auto parent = path.parent_path();
-    auto name = path.filename();
+    mkdir(fs.seek(path.parent_path()), path.filename().string());
+}
 
-    // Lookup destination directory
-    auto node = fs.seek(parent);
+BlockNr
+PosixAdapter::mkdir(BlockNr dir, const string &name)
+{
+    if (wp) throw FSError(FSError::FS_READ_ONLY);
 
     // Create directory
-    auto udb = fs.mkdir(node, FSName(name));
+    auto udb = fs.mkdir(dir, FSName(name));
 
     // Create meta info
     auto &info = ensureMeta(udb);
     info.linkCount = 1;
+
+    return udb;
 }
 
 void
 PosixAdapter::rmdir(const fs::path &path)
+{
+    rmdir(fs.seek(path.parent_path()), path.filename().string());
+}
+
+void
+PosixAdapter::rmdir(BlockNr dir, const string &name)
 {
     if (wp) throw FSError(FSError::FS_READ_ONLY);
-    
+
     // Lookup directory
-    auto node = fs.seek(path);
+    auto node = resolve(dir, name);
 
     // Only empty directories can be removed
-    auto dir = readDir(path);
-    for (auto &it : dir) { printf("DIR item: %s\n", it.c_str()); }
     require.emptyDirectory(node);
-        
+
     // Remove directory entry
     fs.unlink(node);
-    
+
     // Decrement link count
     auto &info = ensureMeta(node);
     if (info.linkCount > 0) info.linkCount--;
-    
+
     // Maybe delete
     tryReclaim(node);
 }
@@ -130,7 +149,7 @@ std::vector<string>
 PosixAdapter::readDir(const fs::path &path) const
 {
     std::vector<string> result;
-    
+
     for (auto &it : fs.getItems(fs.seek(path))) {
         result.push_back(fs.fetch(it).cppName());
     }
@@ -138,12 +157,78 @@ PosixAdapter::readDir(const fs::path &path) const
     return result;
 }
 
+std::vector<FSPosixDirEntry>
+PosixAdapter::readDirPlus(const fs::path &path) const
+{
+    return readDirPlus(fs.seek(path));
+}
+
+std::vector<FSPosixDirEntry>
+PosixAdapter::readDirPlus(BlockNr node) const
+{
+    std::vector<FSPosixDirEntry> result;
+
+    auto &dir = fs.fetch(node);
+    if (!dir.hasHashTable()) throw FSError(FSError::FS_NOT_A_DIRECTORY);
+
+    // Load the blocks referenced by the hash table in ascending order
+    std::vector<BlockNr> refs;
+    for (isize i = 0; i < dir.hashTableSize(); i++) {
+        if (auto ref = dir.getHashRef(i)) refs.push_back(ref);
+    }
+    std::sort(refs.begin(), refs.end());
+    for (auto &it : refs) (void)fs.tryFetch(it);
+
+    // Collect names and attributes in a single traversal
+    for (auto &it : fs.getItems(dir.nr)) {
+        result.push_back(FSPosixDirEntry { .name = fs.fetch(it).cppName(), .node = it, .attr = posixAttr(it) });
+    }
+
+    return result;
+}
+
+FSResult<BlockNr>
+PosixAdapter::tryLookup(BlockNr dir, const string &name) const
+{
+    return fs.lookup(dir, FSName(name));
+}
+
+BlockNr
+PosixAdapter::resolve(BlockNr dir, const string &name) const
+{
+    if (auto node = tryLookup(dir, name)) return *node;
+    else throw FSError(node.error(), name);
+}
+
+void
+PosixAdapter::ref(BlockNr node, isize count)
+{
+    // Lookups run in parallel, so the meta data needs protection here
+    std::lock_guard<std::mutex> guard(refLock);
+    ensureMeta(node).lookupCount += count;
+}
+
+void
+PosixAdapter::forget(BlockNr node, isize count)
+{
+    if (auto *info = getMeta(node); info) {
+
+        info->lookupCount = std::max(isize(0), info->lookupCount - count);
+
+        // Maybe delete
+        tryReclaim(node);
+    }
+}
+
 HandleRef
 PosixAdapter::open(const fs::path &path, u32 flags)
 {
-    // Resolve path
-    auto node = fs.seek(path);
-    
+    return open(fs.seek(path), flags);
+}
+
+HandleRef
+PosixAdapter::open(BlockNr node, u32 flags)
+{
     // Create a unique identifier
     auto ref = HandleRef { ++nextHandle };
     
@@ -158,6 +243,9 @@ PosixAdapter::open(const fs::path &path, u32 flags)
     auto &handle = handles[ref];
     auto &info = ensureMeta(node);
     info.openHandles.insert(ref);
+
+    // Keep the file header block of open files in the block cache
+    fs.pin(node);
     
     // Evaluate flags
     if ((flags & O_TRUNC) && (flags & (O_WRONLY | O_RDWR))) {
@@ -183,6 +271,7 @@ PosixAdapter::close(HandleRef ref)
     
     // Remove from global handle table
     handles.erase(ref);
+    fs.unpin(header);
     
     // Attempt deletion after all references are gone
     tryReclaim(header);
@@ -190,18 +279,24 @@ PosixAdapter::close(HandleRef ref)
 
 void
 PosixAdapter::unlink(const fs::path &path)
+{
+    unlink(fs.seek(path.parent_path()), path.filename().string());
+}
+
+void
+PosixAdapter::unlink(BlockNr dir, const string &name)
 {
     if (wp) throw FSError(FSError::FS_READ_ONLY);
-    
-    auto node = fs.seek(path);
-    
+
+    auto node = resolve(dir, name);
+
     // Remove directory entry
     auto &info = ensureMeta(node);
     fs.unlink(node);
-    
+
     // Decrement link count
     if (info.linkCount > 0) info.linkCount--;
-    
+
     // Maybe delete
     tryReclaim(node);
 }
@@ -211,14 +306,13 @@ PosixAdapter::tryReclaim(BlockNr node)
 {
     if (auto *info = getMeta(node); info) {
 
-        if (info->linkCount == 0 && info->openCount() == 0) {
+        if (info->openCount() || info->lookupCount) return;
 
-            // Delete file
-            fs.reclaim(node);
+        // Delete the file once the last reference is gone
+        if (info->linkCount == 0) fs.reclaim(node);
 
-            // Trash meta data
-            meta.erase(node);
-        }
+        // Trash meta data (it contains default values only otherwise)
+        meta.erase(node);
     }
 }
 
@@ -261,20 +355,22 @@ PosixAdapter::ensureDirectory(const fs::path &path)
 void
 PosixAdapter::create(const fs::path &path)
 {
-    if (wp) throw FSError(FSError::FS_READ_ONLY);
-
-    auto parent = path.parent_path();
-    auto name   = path.filename();
+    create(fs.seek(path.parent_path()), path.filename().string());
+}
 
-    // Lookup destination directory
-    auto node = fs.seek(parent);
+BlockNr
+PosixAdapter::create(BlockNr dir, const string &name)
+{
+    if (wp) throw FSError(FSError::FS_READ_ONLY);
 
     // Create file
-    auto fhb = fs.createFile(node, FSName(name));
+    auto fhb = fs.createFile(dir, FSName(name));
 
     // Create meta info
     auto &info = ensureMeta(fhb);
     info.linkCount = 1;
+
+    return fhb;
 }
 
 isize
@@ -317,48 +413,62 @@ PosixAdapter::move(const fs::path &oldPath, const fs::path &newPath)
     fs.move(src, dst, FSName(newName));
 }
 
+void
+PosixAdapter::move(BlockNr dir, const string &name, BlockNr newDir, const string &newName)
+{
+    if (wp) throw FSError(FSError::FS_READ_ONLY);
+
+    fs.move(resolve(dir, name), newDir, FSName(newName));
+}
+
 void
 PosixAdapter::chmod(const fs::path &path, u32 mode)
+{
+    chmod(ensureFile(path), mode);
+}
+
+void
+PosixAdapter::chmod(BlockNr node, u32 mode)
 {
     if (wp) throw FSError(FSError::FS_READ_ONLY);
 
-    auto &node = fs.fetch(ensureFile(path)).mutate();
+    require.fileOrDirectory(node);
+    auto &block = fs.fetch(node).mutate();
 
-    u32 prot = node.getProtectionBits();
+    u32 prot = block.getProtectionBits();
 
     if (mode & posix::IRUSR) prot &= ~0x01; else prot |= 0x01;
     if (mode & posix::IWUSR) prot &= ~0x02; else prot |= 0x02;
     if (mode & posix::IXUSR) prot &= ~0x04; else prot |= 0x04;
 
-    node.setProtectionBits(prot);
+    block.setProtectionBits(prot);
 }
 
 void
 PosixAdapter::resize(const fs::path &path, isize size)
+{
+    resize(ensureFile(path), size);
+}
+
+void
+PosixAdapter::resize(BlockNr node, isize size)
 {
     if (wp) throw FSError(FSError::FS_READ_ONLY);
 
-    fs.resize(ensureFile(path), size);
+    require.file(node);
+    fs.resize(node, size);
 }
 
 isize
 PosixAdapter::read(HandleRef ref, std::span<u8> buffer)
 {
-    auto &handle = getHandle(ref);
-    auto &node   = fs.fetch(handle.node);
-    auto &meta   = ensureMeta(node.nr);
-
-    // Cache the file if necessary
-    if (meta.cache.empty()) { node.extractData(meta.cache); }
+    // Keep the block cache within its memory budget
+    fs.trim();
 
-    // Check for EOF
-    if (handle.offset >= meta.cache.size) return 0;
-
-    // Compute the number of bytes to read
-    auto count = std::min(meta.cache.size - handle.offset, (isize)buffer.size());
+    auto &handle = getHandle(ref);
 
     // Copy the requested range
-    std::memcpy(buffer.data(), meta.cache.ptr + handle.offset, count);
+    auto count = fs.read(handle.node, buffer.data(), isize(buffer.size()), handle.offset);
 
     // Advance the handle offset
     handle.offset += count;
@@ -366,33 +476,45 @@ PosixAdapter::read(HandleRef ref, std::span<u8> buffer)
     return count;
 }
 
+isize
+PosixAdapter::pread(HandleRef ref, std::span<u8> buffer, isize offset)
+{
+    if (offset < 0) throw FSError(FSError::FS_OUT_OF_RANGE);
+
+    // Copy the requested range (concurrent readers may share the handle)
+    return fs.read(getHandle(ref).node, buffer.data(), isize(buffer.size()), offset);
+}
+
 isize
 PosixAdapter::write(HandleRef ref, std::span<const u8> buffer)
 {
     if (wp) throw FSError(FSError::FS_READ_ONLY);
 
-    auto &handle = getHandle(ref);
-    auto &meta   = ensureMeta(handle.node);
+    // Keep the block cache within its memory budget
+    fs.trim();
 
-    // Cache the file if necessary
-    if (meta.cache.empty()) { fs.fetch(handle.node).extractData(meta.cache); }
+    auto &handle = getHandle(ref);
 
-    // Determine the new file size
-    auto newSize = std::max(meta.cache.size, handle.offset + (isize)buffer.size());
+    // Write the data into the affected blocks
+    auto count = fs.write(handle.node, buffer.data(), isize(buffer.size()), handle.offset);
 
-    // Resize the cached file if necessary (pad with 0)
-    meta.cache.resize(newSize, 0);
+    // Advance the handle offset
+    handle.offset += count;
 
-    // Compute the number of bytes to write
-    auto count = buffer.size();
+    return count;
+}
 
-    // Update data
-    std::memcpy(meta.cache.ptr + handle.offset, buffer.data(), count);
+isize
+PosixAdapter::pwrite(HandleRef ref, std::span<const u8> buffer, isize offset)
+{
+    if (wp) throw FSError(FSError::FS_READ_ONLY);
+    if (offset < 0) throw FSError(FSError::FS_OUT_OF_RANGE);
 
-    // Write back
-    fs.replace(handle.node, meta.cache);
+    // Keep the block cache within its memory budget
+    fs.trim();
 
-    return isize(count);
+    // Write the data into the affected blocks
+    return fs.write(getHandle(ref).node, buffer.data(), isize(buffer.size()), offset);
 }
 
 void
@@ -407,4 +529,16 @@ PosixAdapter::invalidate()
     fs.invalidate();
 }
 
+bool
+PosixAdapter::needsTrim() const noexcept
+{
+    return fs.exceedsCacheBudget();
+}
+
+void
+PosixAdapter::trim()
+{
+    fs.trim();
+}
+
 }
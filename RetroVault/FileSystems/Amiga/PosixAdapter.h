@@ -12,6 +12,7 @@
 #include "FileSystems/PosixView.h"
 #include "FileSystems/Amiga/FileSystem.h"
 #include <fcntl.h>
+#include <mutex>
 
 namespace retro::vault::amiga {
 
@@ -22,12 +23,12 @@ struct NodeMeta {
     // Number of directory entries
     isize linkCount = 1;
 
+    // Number of references held by the host (FUSE lookup count)
+    isize lookupCount = 0;
+
     // All open handles referencing this node
     std::unordered_set<HandleRef> openHandles;
 
-    // File cache
-    Buffer<u8> cache;
-
     // Returns the number of open handles
     isize openCount() { return (isize)openHandles.size(); };
 };
@@ -52,6 +53,9 @@ class PosixAdapter : public PosixView {
     // Handle ID generator
     isize nextHandle{3};
 
+    // Serializes lookup count updates (ref() is called by concurrent readers)
+    std::mutex refLock;
+
 public:
 
     explicit PosixAdapter(FileSystem &fs);
@@ -65,6 +69,7 @@ public:
     
     bool isWriteProtected() const noexcept override { return wp; }
     void writeProtect(bool yesno) noexcept override { wp = yesno; }
+    bool allowsConcurrentReads() const noexcept override { return true; }
     
     
     //
@@ -75,9 +80,16 @@ public:
 
     // Queries information about the file system
     FSPosixStat stat() const noexcept override;
+    isize generation() const noexcept override { return fs.getGeneration(); }
 
     // Queries information about a specific file
-    FSPosixAttr attr(const fs::path &path) const override;
+    FSResult<FSPosixAttr> tryAttr(const fs::path &path) const override;
+    FSResult<FSPosixAttr> tryAttr(BlockNr node) const override;
+
+private:
+
+    // Queries information about a file header or directory block
+    FSPosixAttr posixAttr(BlockNr nr) const;
 
 
     //
@@ -104,12 +116,16 @@ public:
 
     // Creates a directory
     void mkdir(const fs::path &path) override;
+    BlockNr mkdir(BlockNr dir, const string &name) override;
 
     // Removes a directory
     void rmdir(const fs::path &path) override;
+    void rmdir(BlockNr dir, const string &name) override;
 
     // Returns the contents of a directory
     std::vector<string> readDir(const fs::path &path) const override;
+    std::vector<FSPosixDirEntry> readDirPlus(const fs::path &path) const override;
+    std::vector<FSPosixDirEntry> readDirPlus(BlockNr dir) const override;
 
 
     //
@@ -120,31 +136,39 @@ public:
 
     // Opens or closes a file
     HandleRef open(const fs::path &path, u32 flags) override;
+    HandleRef open(BlockNr node, u32 flags) override;
     void close(HandleRef handle) override;
 
     // Creates a new file
     void create(const fs::path &path) override;
+    BlockNr create(BlockNr dir, const string &name) override;
 
     // Removes a file from its directory
     void unlink(const fs::path &path) override;
+    void unlink(BlockNr dir, const string &name) override;
 
     // Moves the file to a different location
     void move(const fs::path &oldPath, const fs::path &newPath) override;
+    void move(BlockNr dir, const string &name, BlockNr newDir, const string &newName) override;
 
     // Changes the size of a file
     void resize(const fs::path &path, isize size) override;
+    void resize(BlockNr node, isize size) override;
 
     // Moves the read/write pointer
     isize lseek(HandleRef ref, isize offset, u16 whence = 0) override;
 
     // Reads data from a file
     isize read(HandleRef ref, std::span<u8> buffer) override;
+    isize pread(HandleRef ref, std::span<u8> buffer, isize offset) override;
 
     // Writes data to a file
     isize write(HandleRef ref, std::span<const u8> buffer) override;
+    isize pwrite(HandleRef ref, std::span<const u8> buffer, isize offset) override;
 
     // Changes file permissions
     void chmod(const fs::path &path, u32 mode) override;
+    void chmod(BlockNr node, u32 mode) override;
 
 private:
 
@@ -155,6 +179,21 @@ private:
     BlockNr ensureFile(const fs::path &path);
     BlockNr ensureFileOrDirectory(const fs::path &path);
     BlockNr ensureDirectory(const fs::path &path);
+
+    // Looks up an item in a directory (throws if the item does not exist)
+    BlockNr resolve(BlockNr dir, const string &name) const;
+
+
+    //
+    // Working with nodes
+    //
+
+public:
+
+    BlockNr root() const noexcept override { return fs.root(); }
+    FSResult<BlockNr> tryLookup(BlockNr dir, const string &name) const override;
+    void ref(BlockNr node, isize count = 1) override;
+    void forget(BlockNr node, isize count) override;
     
     
     //
@@ -165,6 +204,8 @@ public:
     
     void flush() override;
     void invalidate() override;
+    bool needsTrim() const noexcept override;
+    void trim() override;
 };
 
 }
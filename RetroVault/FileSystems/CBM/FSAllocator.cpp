@@ -14,6 +14,46 @@
 
 namespace retro::vault::cbm {
 
+FSAllocator::FSAllocator(FileSystem& fs) : FSService(fs)
+{
+    setPlacement(FSPlacement::legacy());
+}
+
+void
+FSAllocator::setPlacement(const FSPlacement &value)
+{
+    // Number of sectors in each speed zone
+    static constexpr isize numSectors[4] = { 17, 18, 19, 21 };
+
+    for (isize z = 0; z < 4; z++) {
+
+        auto n = numSectors[z];
+        auto k = value.interleave[z];
+
+        if (k < 1 || k >= n) throw FSError(FSError::FS_INVALID_ARGUMENT, "Interleave " + std::to_string(k));
+
+        // Arrange all sectors of a track in interleave order, starting with sector 0
+        std::vector<bool> visited(n);
+        std::vector<SectorNr> order;
+        order.reserve(n);
+
+        for (isize s = 0; isize(order.size()) < n; s = (s + k) % n) {
+
+            // If the sequence runs into a visited sector, continue with its neighbor
+            while (visited[s]) s = (s + 1) % n;
+
+            visited[s] = true;
+            order.push_back(SectorNr(s));
+        }
+
+        // Map each sector to its successor (the last sector maps to sector 0)
+        successor[z].assign(n, 0);
+        for (isize i = 0; i + 1 < n; i++) successor[z][order[i]] = order[i + 1];
+    }
+
+    placement = value;
+}
+
 isize
 FSAllocator::requiredBlocks(isize fileSize) const noexcept
 {
@@ -33,7 +73,8 @@ std::vector<BlockNr>
 FSAllocator::allocate(isize count)
 {
     std::vector<BlockNr> result;
-    TSLink ts = ap;
+    TSLink start = startBlock();
+    TSLink ts = start;
 
     // Gather 'count' free blocks
     while (count > 0) {
@@ -49,7 +90,7 @@ FSAllocator::allocate(isize count)
 
             // Move to the next block
             ts = advance(ts);
-            if (ts != ap) continue;
+            if (ts != start) continue;
         }
         throw FSError(FSError::FS_OUT_OF_SPACE);
     }
@@ -106,19 +147,32 @@ FSAllocator::deallocateBlocks(const std::vector<BlockNr> &nrs)
 }
 
 TSLink
-FSAllocator::advance(TSLink ts)
+FSAllocator::startBlock() const
 {
-    // Interleave patterns used to determine the next sector
-    static constexpr SectorNr next[5][21] = {
+    if (!placement.awayFromDirTrack) return ap;
+
+    // Start on the track closest to the directory track that has free sectors
+    for (TrackNr d = 1; d < traits.numTracks(); d++) {
+
+        for (TrackNr t : { 18 - d, 18 + d }) {
+
+            if (t < 1 || t > traits.numTracks()) continue;
 
-        // Speed zone 0 - 3
-        { 10,11,12,13,14,15,16, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 },
-        { 10,11,12,13,14,15,16,17, 1, 0, 2, 3, 4, 5, 6, 7, 8, 9 },
-        { 10,11,12,13,14,15,16,17,18, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9},
-        { 10,11,12,13,14,15,16,17,18,19,20, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 },
+            for (SectorNr s = 0; s < traits.numSectors(TSLink{t,0}); s++) {
+                if (isFree(TSLink{t,s})) return TSLink{t,0};
+            }
+        }
+    }
 
-        // Directory track
-        {  3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,15,16,17,18, 0, 1, 2 }
+    return ap;
+}
+
+TSLink
+FSAllocator::advance(TSLink ts)
+{
+    // Interleave pattern used to determine the next sector on the directory track
+    static constexpr SectorNr next[19] = {
+        3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,15,16,17,18, 0, 1, 2
     };
 
     if (!traits.isValidLink(ts)) return {0,0};
@@ -129,7 +183,7 @@ FSAllocator::advance(TSLink ts)
     if (t == 18) {
 
         // Take care of the directory track
-        s = next[4][s];
+        s = next[s];
 
         // Return immediately if we've wrapped over (directory track is full)
         if (s == 0) return {0,0};
@@ -137,16 +191,73 @@ FSAllocator::advance(TSLink ts)
     } else {
 
         // Take care of all other tracks
-        s = next[traits.speedZone(ts)][s];
+        s = successor[traits.speedZone(ts)][s];
 
         // Move to the next track if we've wrapped over
-        if (s == 0) t = t >= traits.numTracks() ? 1 : t == 17 ? 19 : t + 1;
+        if (s == 0) {
+
+            if (!placement.awayFromDirTrack) {
+
+                t = t >= traits.numTracks() ? 1 : t == 17 ? 19 : t + 1;
+
+            } else if (t < 18) {
+
+                // Move outwards and continue above the directory track
+                t = t == 1 ? 19 : t - 1;
+
+            } else {
+
+                // Move outwards and continue below the directory track
+                t = t >= traits.numTracks() ? 17 : t + 1;
+            }
+        }
     }
 
     assert(traits.isValidLink(TSLink{t,s}));
     return TSLink{t,s};
 }
 
+double
+FSAllocator::revolutions(const std::vector<BlockNr> &blocks) const
+{
+    return revolutions(blocks, placement);
+}
+
+double
+FSAllocator::revolutions(const std::vector<BlockNr> &blocks, const FSPlacement &loader) const
+{
+    if (blocks.empty()) return 0.0;
+
+    // Wait for the first sector to pass by the drive head (half a revolution on average)
+    double result = 0.5;
+
+    for (usize i = 0; i < blocks.size(); i++) {
+
+        auto ts = traits.tsLink(blocks[i]);
+        if (!ts) continue;
+
+        auto n = traits.numSectors(*ts);
+        auto next = i + 1 < blocks.size() ? traits.tsLink(blocks[i + 1]) : std::nullopt;
+
+        if (next && next->t == ts->t) {
+
+            // The loader needs 'interleave' sectors to read and process a sector.
+            // If the next sector arrives earlier, it is missed for a full revolution.
+            auto gap = (next->s - ts->s + n) % n;
+            if (gap < loader.interleave[traits.speedZone(*ts)]) gap += n;
+
+            result += double(gap) / double(n);
+
+        } else {
+
+            // Read the sector, then wait half a revolution on average after a track change
+            result += 1.0 / double(n) + (next ? 0.5 : 0.0);
+        }
+    }
+
+    return result;
+}
+
 bool
 FSAllocator::isFree(BlockNr nr) const noexcept
 {
@@ -18,9 +18,26 @@ class FSAllocator final : public FSService {
     // Allocation pointer (selects the block to allocate next)
     TSLink ap = {1,0};
 
+    // Placement strategy for new file blocks
+    FSPlacement placement;
+
+    // Successor of each sector in the interleave sequence (one table per speed zone)
+    std::vector<SectorNr> successor[4];
+
+public:
+
+    explicit FSAllocator(FileSystem& fs);
+
+
+    //
+    // Configuring
+    //
+
 public:
 
-    using FSService::FSService;
+    // Gets or sets the placement strategy
+    const FSPlacement &getPlacement() const noexcept { return placement; }
+    void setPlacement(const FSPlacement &value);
 
 
     //
@@ -54,10 +71,24 @@ public:
 
 private:
 
+    // Selects the block where the next allocation starts
+    TSLink startBlock() const;
+
     // Moves to the next block according to the CBM interleaving scheme
     TSLink advance(TSLink ts);
 
 
+    //
+    // Analyzing the block layout
+    //
+
+public:
+
+    // Estimates the number of disk revolutions needed to read a chain of blocks
+    double revolutions(const std::vector<BlockNr> &blocks) const;
+    double revolutions(const std::vector<BlockNr> &blocks, const FSPlacement &loader) const;
+
+
     //
     // Managing the block allocation bitmap
     //
@@ -36,7 +36,9 @@ void
 FSBlock::init(FSBlockType t)
 {
     type = t;
-    dataCache.clear();
+
+    // Freed sectors keep their contents, so scratched files can be recovered
+    if (dataCache && t != FSBlockType::EMPTY) memset(dataCache, 0, bsize());
 
     switch (type) {
 
@@ -211,16 +213,10 @@ FSBlock::itemType(isize byte) const
 u8 *
 FSBlock::data()
 {
-    if (dataCache.empty()) {
-
-        dataCache.alloc(bsize());
-        cache.dev.readBlock(dataCache.ptr, nr);
-    }
-
-    assert(dataCache.size == bsize());
-    assert(dataCache.ptr);
+    if (!dataCache) cache.load(*this);
 
-    return dataCache.ptr;
+    assert(dataCache);
+    return dataCache;
 }
 
 const u8 *
@@ -265,9 +261,10 @@ FSBlock::invalidate()
 void
 FSBlock::flush()
 {
-    if (!dataCache.empty()) {
+    // Mapped blocks have been modified in place and need no write-back
+    if (dataCache && dataCache == buffer.ptr) {
         
-        cache.dev.writeBlock(dataCache.ptr, nr);
+        cache.dev.writeBlock(dataCache, nr);
     }
 }
 
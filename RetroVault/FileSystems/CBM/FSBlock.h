@@ -35,8 +35,11 @@ struct FSBlock : Loggable, Hashable, Dumpable {
     // The number of this block
     BlockNr nr = 0;
 
-    // Cached block data
-    Buffer<u8> dataCache;
+    // Cached block data (aliases the device memory in zero-copy mode)
+    u8 *dataCache = nullptr;
+
+    // Private copy of the block data (unused in zero-copy mode)
+    Buffer<u8> buffer;
 
 
     //
@@ -66,7 +69,7 @@ public:
 
     u64 hash(HashAlgorithm algorithm) const override {
 
-        return dataCache.empty() ? 0 : dataCache.hash(algorithm);
+        return dataCache ? Hashable::hash(dataCache, bsize(), algorithm) : 0;
     }
 
 
@@ -76,10 +79,10 @@ public:
 
     Dumpable::DataProvider dataProvider() const override {
 
-        if (dataCache.empty()) {
+        if (!dataCache) {
             return [&](isize offset, isize bytes) { return offset < bsize() ? 0 : -1; };
         } else {
-            return dataCache.dataProvider();
+            return Dumpable::dataProvider(dataCache, bsize());
         }
     }
 
@@ -17,6 +17,9 @@ namespace retro::vault::cbm {
 
 FSCache::FSCache(FileSystem &fs, Volume &v) : FSService(fs), dev(v) {
 
+    // Blocks of in-memory devices are accessed in place
+    zeroCopy = v.capacity() > 0 && v.mapBlock(0) != nullptr;
+
     blocks.reserve(v.capacity());
 };
 
@@ -38,6 +41,7 @@ FSCache::dump(std::ostream &os) const
 
     os << tab("Capacity") << capacity() << " blocks (x " << bsize() << " bytes)" << std::endl;
     os << tab("Hashed blocks") << blocks.size() << std::endl;
+    os << tab("Zero copy") << (zeroCopy ? "yes" : "no") << std::endl;
 }
 
 FSFormat
@@ -102,19 +106,38 @@ FSCache::cache(BlockNr nr) const noexcept
 
     // Create the block cache entry
     auto block = std::make_unique<FSBlock>(&fs, nr);
-    block->dataCache.alloc(bsize());
 
-    // Read block data from the underlying block device
-    dev.readBlock(block->dataCache.ptr, nr);
+    // Map or read block data from the underlying block device
+    load(*block);
 
     // Predict the block type based on its number and cached data
-    block->type = fs.predictType(nr, block->dataCache.ptr);
+    block->type = fs.predictType(nr, block->dataCache);
 
     // Populate the reserved cache entry
     it->second = std::move(block);
     return it->second.get();
 }
 
+void
+FSCache::load(FSBlock &block) const
+{
+    if (zeroCopy) {
+
+        // Let the block alias the device memory
+        block.dataCache = dev.mapBlock(block.nr);
+
+        // Mapped blocks bypass readBlocks(), so account for the access here
+        dev.reads += bsize();
+
+    } else {
+
+        // Create a private copy of the block data
+        block.buffer.alloc(bsize());
+        dev.readBlock(block.buffer.ptr, block.nr);
+        block.dataCache = block.buffer.ptr;
+    }
+}
+
 const FSBlock *
 FSCache::tryFetch(BlockNr nr) const noexcept
 {
@@ -239,6 +262,7 @@ void
 FSCache::erase(BlockNr nr)
 {
     if (blocks.contains(nr)) { blocks.erase(nr); }
+    dirty.erase(nr);
 }
 
 void
@@ -253,7 +277,16 @@ void
 FSCache::flush()
 {
     loginfo(FS_DEBUG, "Flushing %zd dirty blocks\n", dirty.size());
-    
+
+    // In zero-copy mode, all modifications have been applied in place
+    if (zeroCopy) {
+
+        // Account for the write-back the device did not see
+        dev.writes += isize(dirty.size()) * bsize();
+        dirty.clear();
+        return;
+    }
+
     std::vector<u8> buffer;
     auto bs = bsize();
 
@@ -35,6 +35,9 @@ private:
     // Dirty blocks
     mutable std::unordered_set<BlockNr> dirty;
 
+    // Indicates if blocks alias the device memory instead of copying it
+    bool zeroCopy = false;
+
 
     //
     // Initializing
@@ -110,6 +113,13 @@ public:
     // Caches a block (if not already cached)
     FSBlock *cache(BlockNr nr) const noexcept;
 
+private:
+
+    // Attaches the block data to a block (mapping or copying it)
+    void load(FSBlock &block) const;
+
+public:
+
     // Returns a pointer to a block with read permissions (maybe null)
     const FSBlock *tryFetch(BlockNr nr) const noexcept;
     const FSBlock *tryFetch(BlockNr nr, FSBlockType type) const noexcept;
@@ -145,6 +155,9 @@ public:
     isize dirtyBlocks() const { return (isize)dirty.size(); }
     void markAsDirty(BlockNr nr);
 
+    // Checks if cached blocks alias the memory of the underlying device
+    bool isZeroCopy() const { return zeroCopy; }
+
     void flush();
     void invalidate();
 };
@@ -284,4 +284,22 @@ struct FSDiagnosis
     std::vector<BlockNr> unusedButAllocated;
 };
 
+struct FSPlacement
+{
+    // Sector interleave for each speed zone (zone 0 = tracks 31+, zone 3 = tracks 1 - 17)
+    isize interleave[4] = { 10, 10, 10, 10 };
+
+    // Fill the tracks moving away from the directory track
+    bool awayFromDirTrack = false;
+
+    // Layout of previous versions (interleave 10, tracks 1 - 35 in ascending order)
+    static FSPlacement legacy() { return { }; }
+
+    // Layout of the 1541 DOS (interleave 10, tracks nearby track 18 first)
+    static FSPlacement standard() { return { { 10, 10, 10, 10 }, true }; }
+
+    // Layout matching the interleave of common fast loaders
+    static FSPlacement fastLoader(isize i = 6) { return { { i, i, i, i }, true }; }
+};
+
 }
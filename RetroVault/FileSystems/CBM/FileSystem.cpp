@@ -109,6 +109,25 @@ FileSystem::dumpBlocks(std::ostream &os) const noexcept
     cache.dump(os);
 }
 
+void
+FileSystem::dumpLayout(std::ostream &os) const
+{
+    os << "Name                Blocks  Revolutions" << std::endl;
+
+    for (auto &entry : readDir()) {
+
+        if (entry.deleted() || entry.empty()) continue;
+
+        auto blocks = collectDataBlocks(entry);
+
+        os << std::setw(18) << std::left << std::setfill(' ') << entry.getName().str();
+        os << "  ";
+        os << std::setw(6) << std::left << std::setfill(' ') << blocks.size();
+        os << "  ";
+        os << std::fixed << std::setprecision(2) << allocator.revolutions(blocks) << std::endl;
+    }
+}
+
 bool
 FileSystem::isFormatted() const noexcept
 {
@@ -161,6 +161,7 @@ public:
     FileSystem& operator=(FileSystem &&) = delete;
 
     void stepGeneration() { ++generation; }
+    isize getGeneration() const noexcept { return generation; }
     
     
     //
@@ -172,6 +173,7 @@ public:
     void dumpStatfs(std::ostream &os = std::cout) const noexcept;
     void dumpProps(std::ostream &os = std::cout) const noexcept;
     void dumpBlocks(std::ostream &os = std::cout) const noexcept;
+    void dumpLayout(std::ostream &os = std::cout) const;
 
 
     //
@@ -352,6 +354,14 @@ public:
     // Renames a file
     void rename(const PETName<16> &src, const PETName<16> &dst);
 
+    // Gets or sets the placement strategy for new file blocks
+    const FSPlacement &getPlacement() const noexcept { return allocator.getPlacement(); }
+    void setPlacement(const FSPlacement &value) { allocator.setPlacement(value); }
+
+    // Estimates the number of disk revolutions needed to load a file
+    double revolutions(const FSDirEntry &entry) const;
+    double revolutions(const FSDirEntry &entry, const FSPlacement &loader) const;
+
     // Extracts the data from a file
     isize extractData(BlockNr b, Buffer<u8> &buf) const;
     isize extractData(TSLink ts, Buffer<u8> &buf) const;
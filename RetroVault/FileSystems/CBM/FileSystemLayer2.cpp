@@ -26,7 +26,10 @@ FileSystem::format(FSFormat dos) {
 
     // Start with an empty block device
     for (isize i = 0; i < traits.blocks; i++) {
-        (*this)[i].mutate().init(FSBlockType::EMPTY);
+
+        auto &block = (*this)[i].mutate();
+        block.init(FSBlockType::EMPTY);
+        memset(block.data(), 0, traits.bsize);
     }
 
     // Create the BAM
@@ -69,7 +72,7 @@ FileSystem::formatBAM(FSFormat dos, const PETName<16> &name) {
 
         } else {
 
-            p[0] = (u8)traits.numSectors(k);
+            p[0] = (u8)traits.numSectors(TSLink{k,0});
             p[1] = 0xFF;
             p[2] = 0xFF;
             p[3] = p[0] == 21 ? 0x1F : p[0] == 19 ? 0x07 : p[0] == 18 ? 0x03 : 0x01;
@@ -322,6 +325,18 @@ FileSystem::rename(const PETName<16> &src, const PETName<16> &dst)
     }
 }
 
+double
+FileSystem::revolutions(const FSDirEntry &entry) const
+{
+    return allocator.revolutions(collectDataBlocks(entry));
+}
+
+double
+FileSystem::revolutions(const FSDirEntry &entry, const FSPlacement &loader) const
+{
+    return allocator.revolutions(collectDataBlocks(entry), loader);
+}
+
 isize
 FileSystem::extractData(BlockNr b, Buffer<u8> &buf) const
 {
@@ -60,32 +60,50 @@ PosixAdapter::stat() const noexcept
     };
 }
 
-FSPosixAttr
-PosixAdapter::attr(const fs::path &path) const
+FSResult<FSPosixAttr>
+PosixAdapter::tryAttr(const fs::path &path) const
 {
-    if (auto stat = fs.attr(path)) {
+    if (auto stat = fs.attr(path)) return posixAttr(*stat);
 
-        u32 prot = 0777 | (stat->isDir ? S_IFDIR : S_IFREG);
-                
-        return FSPosixAttr {
+    return std::unexpected(FSError::FS_NOT_FOUND);
+}
 
-            .size           = stat->size,
-            .blocks         = stat->blocks,
-            .prot           = prot,
-            .isDir          = stat->isDir,
+FSResult<FSPosixAttr>
+PosixAdapter::tryAttr(BlockNr node) const
+{
+    if (node == root()) return posixAttr(FSAttr { .size = 0, .blocks = 0, .isDir = true });
+    if (auto item = entry(node)) return posixAttr(fs.attr(*item));
 
-            .btime          = time_t{0},
-            .atime          = time_t{0},
-            .mtime          = time_t{0},
-            .ctime          = time_t{0},
-        };
-    }
+    return std::unexpected(FSError::FS_NOT_FOUND);
+}
 
-    throw FSError(FSError::FS_NOT_FOUND);
+FSPosixAttr
+PosixAdapter::posixAttr(const FSAttr &stat)
+{
+    u32 prot = 0777 | (stat.isDir ? S_IFDIR : S_IFREG);
+
+    return FSPosixAttr {
+
+        .size           = stat.size,
+        .blocks         = stat.blocks,
+        .prot           = prot,
+        .isDir          = stat.isDir,
+
+        .btime          = time_t{0},
+        .atime          = time_t{0},
+        .mtime          = time_t{0},
+        .ctime          = time_t{0},
+    };
 }
 
 void
 PosixAdapter::mkdir(const fs::path &path)
+{
+    mkdir(root(), path.filename().string());
+}
+
+BlockNr
+PosixAdapter::mkdir(BlockNr dir, const string &name)
 {
     if (wp) throw FSError(FSError::FS_READ_ONLY);
 
@@ -94,6 +112,12 @@ PosixAdapter::mkdir(const fs::path &path)
 
 void
 PosixAdapter::rmdir(const fs::path &path)
+{
+    rmdir(root(), path.filename().string());
+}
+
+void
+PosixAdapter::rmdir(BlockNr dir, const string &name)
 {
     if (wp) throw FSError(FSError::FS_READ_ONLY);
 
@@ -113,12 +137,81 @@ PosixAdapter::readDir(const fs::path &path) const
     return result;
 }
 
+std::vector<FSPosixDirEntry>
+PosixAdapter::readDirPlus(BlockNr dir) const
+{
+    std::vector<FSPosixDirEntry> result;
+
+    // CBM file systems are flat
+    if (dir != root()) throw FSError(FSError::FS_NOT_A_DIRECTORY);
+
+    for (auto &item : fs.readDir()) {
+
+        if (item.deleted() || item.empty()) continue;
+
+        if (auto node = fs.getTraits().blockNr(item.firstBlock())) {
+
+            result.push_back(FSPosixDirEntry {
+
+                .name = item.getName().str(),
+                .node = *node,
+                .attr = posixAttr(fs.attr(item))
+            });
+        }
+    }
+
+    return result;
+}
+
+FSResult<BlockNr>
+PosixAdapter::tryLookup(BlockNr dir, const string &name) const
+{
+    // CBM file systems are flat
+    if (dir != root()) return std::unexpected(FSError::FS_NOT_A_DIRECTORY);
+
+    if (auto node = fs.trySeek(name)) return *node;
+    return std::unexpected(FSError::FS_NOT_FOUND);
+}
+
+optional<FSDirEntry>
+PosixAdapter::entry(BlockNr node) const
+{
+    for (auto &item : fs.readDir()) {
+
+        // Deleted slots may still reference the blocks of a former file
+        if (item.deleted() || item.empty()) continue;
+        if (fs.getTraits().blockNr(item.firstBlock()) == node) return item;
+    }
+    return {};
+}
+
+void
+PosixAdapter::ref(BlockNr node, isize count)
+{
+    ensureMeta(node).lookupCount += count;
+}
+
+void
+PosixAdapter::forget(BlockNr node, isize count)
+{
+    if (auto *info = getMeta(node); info) {
+
+        info->lookupCount = std::max(isize(0), info->lookupCount - count);
+
+        // Maybe delete
+        tryReclaim(node);
+    }
+}
+
 HandleRef
 PosixAdapter::open(const fs::path &path, u32 flags)
 {
-    // Resolve path
-    auto node = fs.seek(path);
+    return open(fs.seek(path), flags);
+}
 
+HandleRef
+PosixAdapter::open(BlockNr node, u32 flags)
+{
     // Create a unique identifier
     auto ref = HandleRef { ++nextHandle };
 
@@ -165,10 +258,16 @@ PosixAdapter::close(HandleRef ref)
 
 void
 PosixAdapter::unlink(const fs::path &path)
+{
+    unlink(root(), path.filename().string());
+}
+
+void
+PosixAdapter::unlink(BlockNr dir, const string &name)
 {
     if (wp) throw FSError(FSError::FS_READ_ONLY);
 
-    auto node = fs.seek(path);
+    auto node = resolve(dir, name);
 
     if (auto *info = getMeta(node); info) {
 
@@ -183,12 +282,20 @@ PosixAdapter::unlink(const fs::path &path)
     }
 }
 
+BlockNr
+PosixAdapter::resolve(BlockNr dir, const string &name) const
+{
+    if (auto node = tryLookup(dir, name)) return *node;
+    else throw FSError(node.error(), name);
+}
+
 void
 PosixAdapter::tryReclaim(BlockNr node)
 {
     if (auto *info = getMeta(node); info) {
 
-        if (info->linkCount == 0 && info->openCount() == 0) {
+        // Keep the file as long as it is open or referenced by the host
+        if (info->linkCount == 0 && info->openCount() == 0 && info->lookupCount == 0) {
 
             // Delete file
             fs.reclaim(node);
@@ -239,16 +346,25 @@ PosixAdapter::ensureDirectory(const fs::path &path)
 void
 PosixAdapter::create(const fs::path &path)
 {
-    if (wp) throw FSError(FSError::FS_READ_ONLY);
-    
     auto rel    = path.relative_path();
     auto parent = rel.parent_path();
-    auto name   = rel.filename();
 
     // Reject nested paths (CBM is flat)
     if (!parent.empty() && parent != ".")
         throw FSError(FSError::FS_INVALID_PATH);
 
+    create(root(), rel.filename().string());
+}
+
+BlockNr
+PosixAdapter::create(BlockNr dir, const string &name)
+{
+    if (wp) throw FSError(FSError::FS_READ_ONLY);
+
+    // Reject nested paths (CBM is flat)
+    if (dir != root())
+        throw FSError(FSError::FS_INVALID_PATH);
+
     // Reject invalid names
     if (name.empty() || name == ".")
         throw FSError(FSError::FS_INVALID_PATH);
@@ -259,6 +375,8 @@ PosixAdapter::create(const fs::path &path)
     // Create meta info
     auto &info = ensureMeta(fdb);
     info.linkCount = 1;
+
+    return fdb;
 }
 
 isize
@@ -299,6 +417,18 @@ PosixAdapter::move(const fs::path &oldPath, const fs::path &newPath)
     fs.rename(oldName, newName);
 }
 
+void
+PosixAdapter::move(BlockNr dir, const string &name, BlockNr newDir, const string &newName)
+{
+    if (wp) throw FSError(FSError::FS_READ_ONLY);
+
+    // CBM file systems are flat
+    if (dir != root() || newDir != root())
+        throw FSError(FSError::FS_INVALID_PATH);
+
+    fs.rename(PETName<16>(name), PETName<16>(newName));
+}
+
 void
 PosixAdapter::chmod(const fs::path &path, u32 mode)
 {
@@ -307,12 +437,26 @@ PosixAdapter::chmod(const fs::path &path, u32 mode)
     throw FSError(FSError::FS_UNSUPPORTED);
 }
 
+void
+PosixAdapter::chmod(BlockNr node, u32 mode)
+{
+    if (wp) throw FSError(FSError::FS_READ_ONLY);
+    
+    throw FSError(FSError::FS_UNSUPPORTED);
+}
+
 void
 PosixAdapter::resize(const fs::path &path, isize size)
+{
+    resize(ensureFile(path), size);
+}
+
+void
+PosixAdapter::resize(BlockNr node, isize size)
 {
     if (wp) throw FSError(FSError::FS_READ_ONLY);
     
-    fs.resize(ensureFile(path), size);
+    fs.resize(node, size);
 }
 
 isize
@@ -22,6 +22,9 @@ struct NodeMeta {
     // Number of directory entries
     isize linkCount = 1;
 
+    // Number of references held by the host (FUSE lookup count)
+    isize lookupCount = 0;
+
     // All open handles referencing this node
     std::unordered_set<HandleRef> openHandles;
 
@@ -72,9 +75,19 @@ public:
     
     // Queries information about the file system
     FSPosixStat stat() const noexcept override;
+    isize generation() const noexcept override { return fs.getGeneration(); }
     
     // Queries information about a specific file
-    FSPosixAttr attr(const fs::path &path) const override;
+    FSResult<FSPosixAttr> tryAttr(const fs::path &path) const override;
+    FSResult<FSPosixAttr> tryAttr(BlockNr node) const override;
+
+private:
+
+    // Converts file attributes into their POSIX counterpart
+    static FSPosixAttr posixAttr(const FSAttr &stat);
+
+    // Returns the directory entry of a node
+    optional<FSDirEntry> entry(BlockNr node) const;
     
     
     //
@@ -101,12 +114,16 @@ public:
     
     // Creates a directory
     void mkdir(const fs::path &path) override;
+    BlockNr mkdir(BlockNr dir, const string &name) override;
     
     // Removes a directory
     void rmdir(const fs::path &path) override;
+    void rmdir(BlockNr dir, const string &name) override;
     
     // Returns the contents of a directory
     std::vector<string> readDir(const fs::path &path) const override;
+    std::vector<FSPosixDirEntry> readDirPlus(const fs::path &path) const override { return readDirPlus(root()); }
+    std::vector<FSPosixDirEntry> readDirPlus(BlockNr dir) const override;
     
     
     //
@@ -117,19 +134,24 @@ public:
     
     // Opens or closes a file
     HandleRef open(const fs::path &path, u32 flags) override;
+    HandleRef open(BlockNr node, u32 flags) override;
     void close(HandleRef handle) override;
     
     // Creates a new file
     void create(const fs::path &path) override;
+    BlockNr create(BlockNr dir, const string &name) override;
     
     // Removes a file from its directory
     void unlink(const fs::path &path) override;
+    void unlink(BlockNr dir, const string &name) override;
     
     // Moves the file to a different location
     void move(const fs::path &oldPath, const fs::path &newPath) override;
+    void move(BlockNr dir, const string &name, BlockNr newDir, const string &newName) override;
     
     // Changes the size of a file
     void resize(const fs::path &path, isize size) override;
+    void resize(BlockNr node, isize size) override;
     
     // Moves the read/write pointer
     isize lseek(HandleRef ref, isize offset, u16 whence = 0) override;
@@ -142,6 +164,7 @@ public:
     
     // Changes file permissions
     void chmod(const fs::path &path, u32 mode) override;
+    void chmod(BlockNr node, u32 mode) override;
     
 private:
     
@@ -151,6 +174,21 @@ private:
     
     BlockNr ensureFile(const fs::path &path);
 
+    // Looks up an item in a directory (throws if the item does not exist)
+    BlockNr resolve(BlockNr dir, const string &name) const;
+
+
+    //
+    // Working with nodes
+    //
+
+public:
+
+    BlockNr root() const noexcept override { return fs.bam(); }
+    FSResult<BlockNr> tryLookup(BlockNr dir, const string &name) const override;
+    void ref(BlockNr node, isize count = 1) override;
+    void forget(BlockNr node, isize count) override;
+
     
     //
     // Working with caches
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "utl/abilities/Reflectable.h"
+#include <expected>
 
 namespace retro::vault {
 
@@ -17,6 +18,9 @@ using namespace utl;
 
 using FSFault = long;
 
+// Result of an operation that reports ordinary failures without throwing
+template <typename T> using FSResult = std::expected<T, FSFault>;
+
 struct FSError : public Error {
 
     static constexpr long FS_OK                     = 0;
@@ -95,9 +99,11 @@ struct FSError : public Error {
         }
     }
     
-    int posixErrno() const noexcept {
+    int posixErrno() const noexcept { return posixErrno(payload); }
+
+    static int posixErrno(FSFault fault) noexcept {
         
-        switch (payload) {
+        switch (fault) {
                 
             case FS_OK:                         return 0;
             case FS_CUSTOM:                     return EIO;
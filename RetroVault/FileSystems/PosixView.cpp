@@ -12,4 +12,37 @@
 
 namespace retro::vault {
 
+FSPosixAttr
+PosixView::attr(const fs::path &path) const
+{
+    if (auto result = tryAttr(path)) return *result;
+    else throw FSError(result.error(), path);
+}
+
+std::vector<FSPosixDirEntry>
+PosixView::readDirPlus(const fs::path &path) const
+{
+    std::vector<FSPosixDirEntry> result;
+
+    // Item nodes are not determined by the default implementation
+    for (auto &name : readDir(path)) {
+        result.push_back(FSPosixDirEntry { .name = name, .node = 0, .attr = attr(path / name) });
+    }
+    return result;
+}
+
+isize
+PosixView::pread(HandleRef ref, std::span<u8> buffer, isize offset)
+{
+    lseek(ref, offset);
+    return read(ref, buffer);
+}
+
+isize
+PosixView::pwrite(HandleRef ref, std::span<const u8> buffer, isize offset)
+{
+    lseek(ref, offset);
+    return write(ref, buffer);
+}
+
 }
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "FileSystems/PosixViewTypes.h"
+#include "FileSystems/FSError.h"
 
 namespace retro::vault {
 
@@ -26,6 +27,9 @@ public:
     
     virtual bool isWriteProtected() const noexcept = 0;
     virtual void writeProtect(bool yesno) noexcept = 0;
+
+    // Checks whether const functions and pread() may run in parallel
+    virtual bool allowsConcurrentReads() const noexcept { return false; }
     
     
     //
@@ -34,9 +38,15 @@ public:
     
     // Queries information about the file system
     virtual FSPosixStat stat() const noexcept = 0;
+
+    // Returns the generation counter (increased with every modification)
+    virtual isize generation() const noexcept = 0;
     
-    // Queries information about a specific file
-    virtual FSPosixAttr attr(const fs::path &path) const = 0;
+    // Queries information about a specific file (may throw)
+    virtual FSPosixAttr attr(const fs::path &path) const;
+
+    // Queries information about a specific file (reports misses without throwing)
+    virtual FSResult<FSPosixAttr> tryAttr(const fs::path &path) const = 0;
     
     
     //
@@ -53,6 +63,9 @@ public:
     
     // Returns the contents of a directory
     virtual std::vector<string> readDir(const fs::path &path) const = 0;
+
+    // Returns the contents of a directory together with the item attributes
+    virtual std::vector<FSPosixDirEntry> readDirPlus(const fs::path &path) const;
     
     
     //
@@ -84,14 +97,64 @@ public:
     
     // Reads data from a file
     virtual isize read(HandleRef ref, std::span<u8> buffer) = 0;
+
+    // Reads data from a given position (leaves the read/write pointer untouched)
+    virtual isize pread(HandleRef ref, std::span<u8> buffer, isize offset);
     
     // Writes data to a file
     virtual isize write(HandleRef ref, std::span<const u8> buffer) = 0;
+
+    // Writes data to a given position (leaves the read/write pointer untouched)
+    virtual isize pwrite(HandleRef ref, std::span<const u8> buffer, isize offset);
     
     // Changes file permissions
     virtual void chmod(const fs::path &path, u32 mode) = 0;
     
     
+    //
+    // Working with nodes
+    //
+
+public:
+
+    // Returns the node of the root directory
+    virtual BlockNr root() const noexcept = 0;
+
+    // Looks up an item in a directory (reports misses without throwing)
+    virtual FSResult<BlockNr> tryLookup(BlockNr dir, const string &name) const = 0;
+
+    // Queries information about a specific node (reports misses without throwing)
+    virtual FSResult<FSPosixAttr> tryAttr(BlockNr node) const = 0;
+
+    // Returns the contents of a directory together with the item attributes
+    virtual std::vector<FSPosixDirEntry> readDirPlus(BlockNr dir) const = 0;
+
+    // Adds or removes references held by the host (e.g., FUSE lookup counts).
+    // Nodes are not reclaimed as long as references exist.
+    virtual void ref(BlockNr node, isize count = 1) = 0;
+    virtual void forget(BlockNr node, isize count) = 0;
+
+    // Creates or removes a directory
+    virtual BlockNr mkdir(BlockNr dir, const string &name) = 0;
+    virtual void rmdir(BlockNr dir, const string &name) = 0;
+
+    // Creates or removes a file
+    virtual BlockNr create(BlockNr dir, const string &name) = 0;
+    virtual void unlink(BlockNr dir, const string &name) = 0;
+
+    // Moves an item to a different location
+    virtual void move(BlockNr dir, const string &name, BlockNr newDir, const string &newName) = 0;
+
+    // Opens a file
+    virtual HandleRef open(BlockNr node, u32 flags) = 0;
+
+    // Changes the size of a file
+    virtual void resize(BlockNr node, isize size) = 0;
+
+    // Changes file permissions
+    virtual void chmod(BlockNr node, u32 mode) = 0;
+
+    
     //
     // Working with caches
     //
@@ -101,6 +164,12 @@ public:
 
     // Invalidates all cache entries
     virtual void invalidate() = 0;
+
+    // Checks whether the caches exceed their memory budget
+    virtual bool needsTrim() const noexcept { return false; }
+
+    // Evicts cache entries until the memory budget is met
+    virtual void trim() { }
 };
 
 }
@@ -51,6 +51,13 @@ struct FSPosixAttr {
     time_t ctime;       // Time of last status change
 };
 
+struct FSPosixDirEntry {
+
+    string name;        // Item name
+    BlockNr node;       // Item node (file header or first data block)
+    FSPosixAttr attr;   // Item attributes
+};
+
 struct FSPosixStat {
 
     // Meta data
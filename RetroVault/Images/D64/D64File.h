@@ -96,6 +96,11 @@ public:
 
     isize bsize() const override { return 256; }
 
+    // Sectors are stored back to back, so they can be accessed in place
+    u8 *mapBlock(isize nr) noexcept override {
+        return nr >= 0 && nr < capacity() ? data.ptr + nr * bsize() : nullptr;
+    }
+
 
     //
     // Methods from DiskImage
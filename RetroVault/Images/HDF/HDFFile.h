@@ -110,6 +110,12 @@ public:
 
     isize bsize() const override { return 512; }
 
+    // Blocks are stored back to back, so they can be erased in place
+    void eraseBlocks(Range<isize> r) override {
+        assert(r.subset(Range<isize>(0, capacity())));
+        memset(data.ptr + r.lower * bsize(), 0, r.size() * bsize());
+    }
+
 
     //
     // Providing descriptors